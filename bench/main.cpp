@@ -0,0 +1,252 @@
+#include "synthetic_dump.h"
+
+#include <app/app.h>
+#include <parse/parse.h>
+#include <utils/fs_utils.h>
+#include <utils/reader.h>
+
+#include <argh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    size_t                repeat    = 3;
+    size_t                threads   = 1;
+    std::vector<size_t>   scales    = {1, 10, 100};
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    SyntheticDumpOptions  shape; // of scale 1
+};
+
+// a dump of the given scale, with `scale` times the objects and coroutine trees of the base shape
+// and classes growing 10 times slower; lengths, depth and fanout stay as they are
+SyntheticDumpOptions dumpOptions(const BenchOptions& bench, size_t scale) {
+    SyntheticDumpOptions options = bench.shape;
+    options.numClasses           = bench.shape.numClasses + bench.shape.numClasses / 10 * scale;
+    options.numInstances         = bench.shape.numInstances * scale;
+    options.numObjectArrays      = bench.shape.numObjectArrays * scale;
+    options.numPrimitiveArrays   = bench.shape.numPrimitiveArrays * scale;
+    options.numCoroutineTrees    = bench.shape.numCoroutineTrees * scale;
+    return options;
+}
+
+// stands in for std::cout while printing is timed
+class Discard : public std::streambuf {
+
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
+
+// best of `repeat` runs, so that noise only ever makes results slower
+template <typename F>
+double bestSeconds(size_t repeat, F&& f) {
+    double best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < repeat; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best                                        = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+class BenchSuite {
+
+public:
+    BenchSuite(const BenchOptions& options, size_t scale, size_t dumpBytes, size_t dumpRecords)
+      : options_(options)
+      , scale_(scale)
+      , dumpBytes_(dumpBytes)
+      , dumpRecords_(dumpRecords) {}
+
+public:
+    // throughput is over the whole dump, records include sub-records
+    void run(const std::string& name, const std::function<void()>& f) {
+        const double seconds = bestSeconds(options_.repeat, f);
+        std::cout << std::format("{:>6} {:<40} {:>10.3f} ms {:>10.1f} MB/s {:>12.0f} records/s\n",
+                                 scale_,
+                                 name,
+                                 seconds * 1e3,
+                                 static_cast<double>(dumpBytes_) / seconds / 1e6,
+                                 static_cast<double>(dumpRecords_) / seconds);
+    }
+
+private:
+    const BenchOptions& options_;
+    size_t              scale_;
+    size_t              dumpBytes_;
+    size_t              dumpRecords_;
+};
+
+// keeps results alive so that the compiler cannot drop the work
+template <typename T>
+void consume(const T& value) {
+    static volatile size_t sink;
+    sink = sink + value.size();
+}
+
+void runScale(const BenchOptions& options, size_t scale) {
+    auto path = options.directory / std::format("dump-analyzer-bench-{}-{}.hprof", scale, options.shape.identifierSize);
+    const auto stats = writeSyntheticDump(path, dumpOptions(options, scale));
+
+    MappedFile file(path);
+    R          dump(file.data(), file.size());
+    dump.skip(std::string_view("JAVA PROFILE 1.0.2").size() + 1);
+    const auto header         = parseDumpHeader(dump);
+    const auto identifierSize = header.identifierSize;
+    const auto directory      = buildRecordDirectory(dump, identifierSize);
+
+    BenchSuite suite(options, scale, file.size(), stats.numRecords + stats.numSubRecords);
+    std::cout << std::format("\nscale {}: {:.1f} MB, {} records, {} sub-records, {} coroutines\n\n",
+                             scale,
+                             static_cast<double>(file.size()) / 1e6,
+                             stats.numRecords,
+                             stats.numSubRecords,
+                             stats.numCoroutines);
+
+    suite.run("summarizeDump", [&] { consume(summarizeDump(dump, identifierSize).tagCounts); });
+    suite.run("buildRecordDirectory", [&] { consume(buildRecordDirectory(dump, identifierSize).records); });
+    suite.run("parseDump", [&] { consume(parseDump(dump, identifierSize).strings); });
+    if (options.threads > 1) {
+        suite.run(std::format("parseDump ({} threads)", options.threads),
+                  [&] { consume(parseDump(dump, identifierSize, options.threads).strings); });
+    }
+
+    const DumpBody body(dump, directory);
+    suite.run("parseStrings", [&] { consume(parseStrings(body, identifierSize)); });
+    suite.run("parseLoadClasses", [&] { consume(parseLoadClasses(body, header)); });
+    suite.run("parseStackFrames", [&] { consume(parseStackFrames(body, identifierSize)); });
+    suite.run("parseStackTraces", [&] { consume(parseStackTraces(body, identifierSize)); });
+    suite.run("parseClassDumps", [&] { consume(parseClassDumps(body, identifierSize)); });
+    suite.run("countInstances", [&] { consume(countInstances(body, identifierSize)); });
+    suite.run("parseAllInstanceLocations", [&] { consume(parseAllInstanceLocations(body, identifierSize)); });
+    suite.run("parseInstanceDumps", [&] { consume(parseInstanceDumps(body, identifierSize)); });
+    {
+        // instances of the most common class, as a query for one class would look them up
+        const auto counts = countInstances(body, identifierSize);
+        const auto target = std::max_element(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+            return a.second < b.second;
+        });
+        if (target != counts.end()) {
+            suite.run("parseClassInstances",
+                      [&] { consume(parseClassInstances(body, identifierSize, target->first)); });
+        }
+    }
+    suite.run("parseObjectArrayDumps", [&] { consume(parseObjectArrayDumps(body, identifierSize)); });
+    suite.run("parsePrimitiveArrayDumps", [&] { consume(parsePrimitiveArrayDumps(body, identifierSize)); });
+    suite.run("parseRootThreads", [&] { consume(parseRootThreads(body, identifierSize)); });
+
+    // the coroutine queries run on a loaded dump, as they do in the tool
+    App  app;
+    Args args;
+    args.dumpFile = path;
+    args.threads  = options.threads;
+    args.useIndex = false;
+    // after the first run, this includes unloading the tables of the run before
+    suite.run("App::load", [&] { app.load(args); });
+
+    std::unordered_set<ObjectID> coroutines;
+    suite.run("getCoroutineInstances", [&] { coroutines = app.getCoroutineInstances(); });
+    if (coroutines.size() != stats.numCoroutines) {
+        throw std::runtime_error(
+            std::format("found {} coroutines instead of {}", coroutines.size(), stats.numCoroutines));
+    }
+
+    Discard discard;
+    suite.run("printCoroutinesHierarchy", [&] {
+        auto* coutBuffer = std::cout.rdbuf(&discard);
+        app.printCoroutinesHierarchy(coroutines);
+        std::cout.rdbuf(coutBuffer);
+    });
+
+    std::filesystem::remove(path);
+}
+
+BenchOptions parseBenchArgs(char* argv[]) {
+    BenchOptions options;
+    argh::parser cmdl(argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    if (!(cmdl("repeat", options.repeat) >> options.repeat) || options.repeat == 0) {
+        throw std::runtime_error("--repeat must be a positive number");
+    }
+    if (!(cmdl("threads", options.threads) >> options.threads) || options.threads == 0) {
+        throw std::runtime_error("--threads must be a positive number");
+    }
+    auto& shape = options.shape;
+    if (!(cmdl("id-size", shape.identifierSize) >> shape.identifierSize) ||
+        (shape.identifierSize != 4 && shape.identifierSize != 8)) {
+        throw std::runtime_error("--id-size must be 4 or 8");
+    }
+    if (!(cmdl("segment-bytes", shape.segmentBytes) >> shape.segmentBytes)) {
+        throw std::runtime_error("--segment-bytes must be a number, 0 for a single HEAP_DUMP record");
+    }
+    if (!(cmdl("seed", shape.seed) >> shape.seed)) {
+        throw std::runtime_error("--seed must be a number");
+    }
+    // the shape of scale 1, which dumpOptions scales
+    const std::pair<const char*, size_t*> counts[] = {
+        {"classes", &shape.numClasses},
+        {"instances", &shape.numInstances},
+        {"object-arrays", &shape.numObjectArrays},
+        {"object-array-length", &shape.objectArrayLength},
+        {"primitive-arrays", &shape.numPrimitiveArrays},
+        {"primitive-array-length", &shape.primitiveArrayLength},
+        {"coroutine-trees", &shape.numCoroutineTrees},
+        {"coroutine-depth", &shape.coroutineTreeDepth},
+        {"coroutine-fanout", &shape.coroutineFanout},
+    };
+    for (const auto& [name, count] : counts) {
+        if (!(cmdl(name, *count) >> *count)) {
+            throw std::runtime_error(std::format("--{} must be a number", name));
+        }
+    }
+    cmdl("dir", options.directory) >> options.directory;
+    // a comma-separated list of scales
+    if (std::string value; cmdl("scale") >> value) {
+        options.scales.clear();
+        std::istringstream scales(value);
+        for (std::string scale; std::getline(scales, scale, ',');) {
+            size_t parsed = 0;
+            size_t factor = 0;
+            try {
+                factor = std::stoull(scale, &parsed);
+            } catch (const std::exception&) {
+            }
+            if (factor == 0 || parsed != scale.size()) {
+                throw std::runtime_error("--scale must be a comma-separated list of positive numbers");
+            }
+            options.scales.push_back(factor);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int, char* argv[]) try {
+    const auto options = parseBenchArgs(argv);
+    for (const auto scale : options.scales) {
+        runScale(options, scale);
+    }
+} catch (const std::exception& e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,492 @@
+#include "synthetic_dump.h"
+
+#include <data/data.h>
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t MILLIS = 1700000000000;
+
+// IDs look like addresses of 16-byte aligned objects
+constexpr ID FIRST_OBJECT_ID = 0x100000;
+constexpr ID OBJECT_ID_STEP  = 0x10;
+constexpr ID FIRST_STRING_ID = 0x1000;
+
+constexpr size_t MAX_FILLER_FIELDS = 8;
+
+constexpr uint32_t STACK_TRACE_SERIAL_NUMBER = 1;
+constexpr uint32_t THREAD_SERIAL_NUMBER      = 1;
+
+constexpr std::array<BasicType, 9> FIELD_TYPES = {BasicType::OBJECT,
+                                                  BasicType::BOOLEAN,
+                                                  BasicType::CHAR,
+                                                  BasicType::FLOAT,
+                                                  BasicType::DOUBLE,
+                                                  BasicType::BYTE,
+                                                  BasicType::SHORT,
+                                                  BasicType::INT,
+                                                  BasicType::LONG};
+
+// big-endian encoder of record bodies
+class Buffer {
+
+public:
+    explicit Buffer(size_t identifierSize)
+      : identifierSize_(identifierSize) {}
+
+public:
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+        putBigEndian(static_cast<uint64_t>(value), sizeof(T));
+    }
+
+    void putID(ID id) {
+        putBigEndian(id, identifierSize_);
+    }
+
+    void putBigEndian(uint64_t value, size_t size) {
+        for (size_t i = size; i > 0; --i) {
+            bytes_.push_back(static_cast<char>(value >> ((i - 1) * 8)));
+        }
+    }
+
+    void putBytes(std::string_view bytes) {
+        bytes_.append(bytes);
+    }
+
+    const std::string& bytes() const {
+        return bytes_;
+    }
+
+    size_t size() const {
+        return bytes_.size();
+    }
+
+    void clear() {
+        bytes_.clear();
+    }
+
+private:
+    size_t      identifierSize_;
+    std::string bytes_;
+};
+
+struct SyntheticField {
+    std::string_view name;
+    StringID         nameStringID;
+    BasicType        type;
+};
+
+struct SyntheticClass {
+    ID                          id;
+    ID                          superclassID;
+    StringID                    nameStringID;
+    std::vector<SyntheticField> fields;    // declared by the class itself
+    std::vector<SyntheticField> allFields; // in instance dump order: own, then the superclasses'
+    uint32_t                    instanceSize = 0;
+};
+
+class SyntheticDumpWriter {
+
+public:
+    SyntheticDumpWriter(const std::filesystem::path& path, const SyntheticDumpOptions& options)
+      : options_(options)
+      , random_(options.seed)
+      , record_(options.identifierSize)
+      , segment_(options.identifierSize) {
+        if (options.identifierSize != 4 && options.identifierSize != 8) {
+            throw std::runtime_error(std::format("unsupported identifier size {}", options.identifierSize));
+        }
+        fout_.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        fout_.open(path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    }
+
+public:
+    SyntheticDumpStats write() {
+        writeHeader();
+        declareClasses();
+        writeStackTrace();
+
+        for (const auto& c : classes_) {
+            writeClassDump(c);
+            writeRoot(SubTag::ROOT_STICKY_CLASS, c.id);
+        }
+        writeThread();
+        writeCoroutines();
+        writeInstances();
+        writeObjectArrays();
+        writePrimitiveArrays();
+        finishHeapDump();
+
+        stats_.fileSize = static_cast<size_t>(fout_.tellp());
+        return stats_;
+    }
+
+private:
+    void writeHeader() {
+        constexpr std::string_view MAGIC = "JAVA PROFILE 1.0.2";
+        fout_.write(MAGIC.data(), MAGIC.size() + 1); // with the terminating zero
+        Buffer header(options_.identifierSize);
+        header.put(static_cast<uint32_t>(options_.identifierSize));
+        header.put(MILLIS);
+        fout_.write(header.bytes().data(), header.size());
+    }
+
+    void writeRecord(Tag tag, const Buffer& body) {
+        if (body.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("record is too large, use smaller segments");
+        }
+        Buffer header(options_.identifierSize);
+        header.put(tag);
+        header.put(uint32_t{0}); // micros
+        header.put(static_cast<uint32_t>(body.size()));
+        fout_.write(header.bytes().data(), header.size());
+        fout_.write(body.bytes().data(), body.size());
+        ++stats_.numRecords;
+    }
+
+    // sub-records are buffered until a segment is complete
+    Buffer& subRecord(SubTag subTag) {
+        if (options_.segmentBytes != 0 && segment_.size() >= options_.segmentBytes) {
+            writeRecord(Tag::HEAP_DUMP_SEGMENT, segment_);
+            segment_.clear();
+        }
+        segment_.put(subTag);
+        ++stats_.numSubRecords;
+        return segment_;
+    }
+
+    void finishHeapDump() {
+        if (options_.segmentBytes == 0) {
+            writeRecord(Tag::HEAP_DUMP, segment_);
+        } else {
+            writeRecord(Tag::HEAP_DUMP_SEGMENT, segment_);
+            writeRecord(Tag::HEAP_DUMP_END, Buffer(options_.identifierSize));
+        }
+        segment_.clear();
+    }
+
+    StringID string(std::string_view text) {
+        const StringID id{nextStringID_++};
+        record_.clear();
+        record_.putID(static_cast<ID>(id));
+        record_.putBytes(text);
+        writeRecord(Tag::STRING_IN_UTF8, record_);
+        return id;
+    }
+
+    ID newObjectID() {
+        const ID id = nextObjectID_;
+        if (options_.identifierSize == 4 && id > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("too many objects for 4-byte identifiers");
+        }
+        nextObjectID_ += OBJECT_ID_STEP;
+        return id;
+    }
+
+    uint64_t next(uint64_t bound) {
+        return bound == 0 ? 0 : random_() % bound;
+    }
+
+    size_t declareClass(std::string_view                                           name,
+                        std::optional<size_t>                                      superclass,
+                        const std::vector<std::pair<std::string_view, BasicType>>& fields) {
+        auto& c        = classes_.emplace_back();
+        c.id           = newObjectID();
+        c.superclassID = superclass.has_value() ? classes_[*superclass].id : 0;
+        c.nameStringID = string(name);
+        for (const auto& [fieldName, type] : fields) {
+            c.fields.push_back(field(fieldName, type));
+            c.instanceSize += static_cast<uint32_t>(basicTypeSize(type, options_.identifierSize));
+        }
+        c.allFields = c.fields;
+        if (superclass.has_value()) {
+            const auto& s = classes_[*superclass];
+            c.allFields.insert(c.allFields.end(), s.allFields.begin(), s.allFields.end());
+            c.instanceSize += s.instanceSize;
+        }
+
+        record_.clear();
+        record_.put(static_cast<uint32_t>(classes_.size())); // class serial number
+        record_.putID(c.id);
+        record_.put(STACK_TRACE_SERIAL_NUMBER);
+        record_.putID(static_cast<ID>(c.nameStringID));
+        writeRecord(Tag::LOAD_CLASS, record_);
+        return classes_.size() - 1;
+    }
+
+    // field names are shared between classes, as in the JVM
+    SyntheticField field(std::string_view name, BasicType type) {
+        auto it = fieldNames_.find(name);
+        if (it == fieldNames_.end()) {
+            it = fieldNames_.emplace(std::string(name), string(name)).first;
+        }
+        return {it->first, it->second, type};
+    }
+
+    void declareClasses() {
+        using enum BasicType;
+        // the JDK and kotlinx classes are looked up by name, the rest are filler
+        object_           = declareClass("java/lang/Object", std::nullopt, {});
+        const auto job    = declareClass("kotlinx/coroutines/JobSupport",
+                                         object_,
+                                         {{"_state$volatile", OBJECT}, {"_parentHandle$volatile", OBJECT}});
+        const auto abstr  = declareClass("kotlinx/coroutines/AbstractCoroutine", job, {{"context", OBJECT}});
+        standalone_       = declareClass("kotlinx/coroutines/StandaloneCoroutine", abstr, {});
+        scope_            = declareClass("kotlinx/coroutines/internal/ScopeCoroutine", abstr, {});
+        const auto node   = declareClass("kotlinx/coroutines/JobNode", object_, {{"job", OBJECT}});
+        childHandleNode_  = declareClass("kotlinx/coroutines/ChildHandleNode", node, {{"childJob", OBJECT}});
+        empty_            = declareClass("kotlinx/coroutines/Empty", object_, {{"isActive", BOOLEAN}});
+        nodeList_         = declareClass("kotlinx/coroutines/NodeList", object_, {});
+        thread_           = declareClass("java/lang/Thread", object_, {{"name", OBJECT}, {"priority", INT}});
+        string_           = declareClass("java/lang/String", object_, {{"value", OBJECT}, {"hash", INT}});
+        objectArrayClass_ = declareClass("[Ljava/lang/Object;", object_, {});
+        firstFiller_      = classes_.size();
+
+        std::vector<std::string> names;
+        for (size_t f = 0; f < MAX_FILLER_FIELDS; ++f) {
+            names.push_back(std::format("f{}", f));
+        }
+        for (size_t i = 0; i < options_.numClasses; ++i) {
+            std::vector<std::pair<std::string_view, BasicType>> fields;
+            const size_t                                        numFields = 1 + next(MAX_FILLER_FIELDS);
+            for (size_t f = 0; f < numFields; ++f) {
+                fields.emplace_back(names[f], FIELD_TYPES[next(FIELD_TYPES.size())]);
+            }
+            // every fourth class extends an earlier filler class
+            const size_t superclass = i > 0 && next(4) == 0 ? firstFiller_ + next(i) : object_;
+            declareClass(std::format("bench/Class{}", i), superclass, fields);
+        }
+    }
+
+    void writeStackTrace() {
+        // strings are records of their own, so they go before the frame
+        const auto methodName = string("run");
+        const auto signature  = string("()V");
+        const auto sourceFile = string("Main.kt");
+        record_.clear();
+        record_.putID(frameID_);
+        record_.putID(static_cast<ID>(methodName));
+        record_.putID(static_cast<ID>(signature));
+        record_.putID(static_cast<ID>(sourceFile));
+        record_.put(uint32_t{1}); // class serial number
+        record_.put(int32_t{42}); // line
+        writeRecord(Tag::STACK_FRAME, record_);
+
+        record_.clear();
+        record_.put(STACK_TRACE_SERIAL_NUMBER);
+        record_.put(THREAD_SERIAL_NUMBER);
+        record_.put(uint32_t{1});
+        record_.putID(frameID_);
+        writeRecord(Tag::STACK_TRACE, record_);
+    }
+
+    void writeClassDump(const SyntheticClass& c) {
+        auto& b = subRecord(SubTag::CLASS_DUMP);
+        b.putID(c.id);
+        b.put(STACK_TRACE_SERIAL_NUMBER);
+        b.putID(c.superclassID);
+        for (size_t i = 0; i < 5; ++i) {
+            b.putID(0); // class loader, signers, protection domain, reserved
+        }
+        b.put(c.instanceSize);
+        b.put(uint16_t{0}); // constant pool
+        b.put(uint16_t{0}); // static fields
+        b.put(static_cast<uint16_t>(c.fields.size()));
+        for (const auto& f : c.fields) {
+            b.putID(static_cast<ID>(f.nameStringID));
+            b.put(f.type);
+        }
+    }
+
+    void writeRoot(SubTag subTag, ID id) {
+        auto& b = subRecord(subTag);
+        b.putID(id);
+        switch (subTag) {
+        case SubTag::ROOT_JNI_GLOBAL:
+            b.putID(0); // JNI global ref ID
+            break;
+        case SubTag::ROOT_JAVA_FRAME:
+        case SubTag::ROOT_THREAD_OBJECT:
+            b.put(THREAD_SERIAL_NUMBER);
+            b.put(subTag == SubTag::ROOT_JAVA_FRAME ? uint32_t{0} : STACK_TRACE_SERIAL_NUMBER);
+            break;
+        default: break;
+        }
+    }
+
+    // field values by name, the rest are random primitives or references to earlier instances
+    void writeInstance(ID id, const SyntheticClass& c, const std::vector<std::pair<std::string_view, ID>>& values) {
+        auto& b = subRecord(SubTag::INSTANCE_DUMP);
+        b.putID(id);
+        b.put(STACK_TRACE_SERIAL_NUMBER);
+        b.putID(c.id);
+        b.put(c.instanceSize);
+        for (const auto& f : c.allFields) {
+            const auto value = std::ranges::find(values, f.name, &std::pair<std::string_view, ID>::first);
+            if (value != values.end()) {
+                b.putBigEndian(value->second, basicTypeSize(f.type, options_.identifierSize));
+            } else if (f.type == BasicType::OBJECT) {
+                b.putID(randomReference());
+            } else {
+                b.putBigEndian(random_(), basicTypeSize(f.type, options_.identifierSize));
+            }
+        }
+    }
+
+    // one of the filler instances written so far, or null
+    ID randomReference() {
+        if (numFillerInstances_ == 0 || next(4) == 0) {
+            return 0;
+        }
+        return firstFillerInstanceID_ + next(numFillerInstances_) * OBJECT_ID_STEP;
+    }
+
+    void writeThread() {
+        constexpr std::string_view NAME = "main";
+
+        const ID chars = newObjectID();
+        auto&    b     = subRecord(SubTag::PRIMITIVE_ARRAY_DUMP);
+        b.putID(chars);
+        b.put(STACK_TRACE_SERIAL_NUMBER);
+        b.put(static_cast<uint32_t>(NAME.size()));
+        b.put(BasicType::BYTE);
+        b.putBytes(NAME);
+
+        const ID name = newObjectID();
+        writeInstance(name, classes_[string_], {{"value", chars}, {"hash", 0}});
+        const ID thread = newObjectID();
+        writeInstance(thread, classes_[thread_], {{"name", name}, {"priority", 5}});
+        writeRoot(SubTag::ROOT_THREAD_OBJECT, thread);
+    }
+
+    void writeCoroutines() {
+        const ID emptyActive = newObjectID();
+        writeInstance(emptyActive, classes_[empty_], {{"isActive", 1}});
+        const ID nodeList = newObjectID();
+        writeInstance(nodeList, classes_[nodeList_], {});
+
+        for (size_t tree = 0; tree < options_.numCoroutineTrees; ++tree) {
+            // breadth first, so that parents are written before their children
+            std::vector<ID> level = {0};
+            for (size_t depth = 0; depth < options_.coroutineTreeDepth; ++depth) {
+                const bool      leaf     = depth + 1 == options_.coroutineTreeDepth;
+                const size_t    children = depth == 0 ? 1 : options_.coroutineFanout;
+                std::vector<ID> nextLevel;
+                for (const ID parent : level) {
+                    for (size_t child = 0; child < children; ++child) {
+                        const ID coroutine    = newObjectID();
+                        ID       parentHandle = 0;
+                        if (parent != 0) {
+                            parentHandle = newObjectID();
+                            writeInstance(parentHandle,
+                                          classes_[childHandleNode_],
+                                          {{"job", parent}, {"childJob", coroutine}});
+                        } else {
+                            writeRoot(SubTag::ROOT_JAVA_FRAME, coroutine);
+                        }
+                        const auto& c = classes_[stats_.numCoroutines % 5 == 0 ? scope_ : standalone_];
+                        writeInstance(coroutine,
+                                      c,
+                                      {{"_state$volatile", leaf ? emptyActive : nodeList},
+                                       {"_parentHandle$volatile", parentHandle},
+                                       {"context", 0}});
+                        nextLevel.push_back(coroutine);
+                        ++stats_.numCoroutines;
+                    }
+                }
+                level = std::move(nextLevel);
+            }
+        }
+    }
+
+    void writeInstances() {
+        if (options_.numClasses == 0 || options_.numInstances == 0) {
+            return;
+        }
+        firstFillerInstanceID_ = nextObjectID_;
+        for (size_t i = 0; i < options_.numInstances; ++i) {
+            const ID id = newObjectID();
+            writeInstance(id, classes_[firstFiller_ + next(options_.numClasses)], {});
+            ++numFillerInstances_;
+        }
+    }
+
+    void writeObjectArrays() {
+        for (size_t i = 0; i < options_.numObjectArrays; ++i) {
+            const ID id = newObjectID();
+            auto&    b  = subRecord(SubTag::OBJECT_ARRAY_DUMP);
+            b.putID(id);
+            b.put(STACK_TRACE_SERIAL_NUMBER);
+            b.put(static_cast<uint32_t>(options_.objectArrayLength));
+            b.putID(classes_[objectArrayClass_].id);
+            for (size_t e = 0; e < options_.objectArrayLength; ++e) {
+                b.putID(randomReference());
+            }
+            // the arrays keep the filler instances reachable
+            writeRoot(SubTag::ROOT_JNI_GLOBAL, id);
+        }
+    }
+
+    void writePrimitiveArrays() {
+        for (size_t i = 0; i < options_.numPrimitiveArrays; ++i) {
+            const auto type = FIELD_TYPES[1 + next(FIELD_TYPES.size() - 1)];
+            auto&      b    = subRecord(SubTag::PRIMITIVE_ARRAY_DUMP);
+            b.putID(newObjectID());
+            b.put(STACK_TRACE_SERIAL_NUMBER);
+            b.put(static_cast<uint32_t>(options_.primitiveArrayLength));
+            b.put(type);
+            const size_t elementSize = basicTypeSize(type, options_.identifierSize);
+            for (size_t e = 0; e < options_.primitiveArrayLength; ++e) {
+                b.putBigEndian(random_(), elementSize);
+            }
+        }
+    }
+
+private:
+    SyntheticDumpOptions                         options_;
+    std::mt19937_64                              random_;
+    std::ofstream                                fout_;
+    Buffer                                       record_;  // of the record being written
+    Buffer                                       segment_; // sub-records of the current heap dump segment
+    SyntheticDumpStats                           stats_;
+    std::vector<SyntheticClass>                  classes_;
+    std::map<std::string, StringID, std::less<>> fieldNames_;
+    ID                                           nextStringID_          = FIRST_STRING_ID;
+    ID                                           nextObjectID_          = FIRST_OBJECT_ID;
+    ID                                           frameID_               = 0x77;
+    ID                                           firstFillerInstanceID_ = 0;
+    size_t                                       numFillerInstances_    = 0;
+
+    // indices of the classes in classes_
+    size_t object_           = 0;
+    size_t standalone_       = 0;
+    size_t scope_            = 0;
+    size_t childHandleNode_  = 0;
+    size_t empty_            = 0;
+    size_t nodeList_         = 0;
+    size_t thread_           = 0;
+    size_t string_           = 0;
+    size_t objectArrayClass_ = 0;
+    size_t firstFiller_      = 0; // the bench/Class<N> classes follow
+};
+
+} // namespace
+
+SyntheticDumpStats writeSyntheticDump(const std::filesystem::path& path, const SyntheticDumpOptions& options) {
+    return SyntheticDumpWriter(path, options).write();
+}
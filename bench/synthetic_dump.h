@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// shape of a generated dump; the same options always produce the same bytes
+struct SyntheticDumpOptions {
+    size_t identifierSize = 8; // 4 or 8
+
+    size_t numClasses           = 100; // besides the JDK and kotlinx classes the coroutines need
+    size_t numInstances         = 100000;
+    size_t numObjectArrays      = 1000;
+    size_t objectArrayLength    = 64;
+    size_t numPrimitiveArrays   = 1000;
+    size_t primitiveArrayLength = 256;
+
+    // sub-records are split into HEAP_DUMP_SEGMENT records of about this size, 0 for a single HEAP_DUMP
+    size_t segmentBytes = size_t{1} << 20;
+
+    // trees of StandaloneCoroutine linked through ChildHandleNode as kotlinx.coroutines does
+    size_t numCoroutineTrees  = 10;
+    size_t coroutineTreeDepth = 3;
+    size_t coroutineFanout    = 4;
+
+    uint64_t seed = 1;
+};
+
+struct SyntheticDumpStats {
+    size_t numRecords    = 0;
+    size_t numSubRecords = 0;
+    size_t numCoroutines = 0;
+    size_t fileSize      = 0;
+};
+
+SyntheticDumpStats writeSyntheticDump(const std::filesystem::path& path, const SyntheticDumpOptions& options);
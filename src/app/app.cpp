@@ -1,15 +1,19 @@
 #include <app/app.h>
 
 #include <utils/forest.h>
-#include <utils/fs_utils.h>
+#include <utils/gzip.h>
+#include <utils/parallel.h>
 
 #include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <format>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <stack>
 #include <stdexcept>
+#include <system_error>
 #include <tuple>
 #include <unordered_set>
 
@@ -56,31 +60,202 @@ void printDumpSummary(const DumpSummary& dumpSummary) {
     }
 }
 
+// strings are saved as their location in the dump, which is mapped anyway,
+// or in the STRING_CONTENTS section if the dump is gzipped
+struct SavedString {
+    StringID id;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// entry of a map to counts, in a form that can be saved as is
+template <typename K>
+struct CountOf {
+    CountOf() = default;
+
+    CountOf(const std::pair<const K, size_t>& entry)
+      : key(entry.first)
+      , count(entry.second) {}
+
+    K      key;
+    size_t count;
+};
+
+// values of a map that are keyed by one of their own fields
+template <typename K, typename V, typename... Rest>
+std::vector<std::byte> packValues(const std::unordered_map<K, V, Rest...>& table) {
+    std::vector<V> values;
+    values.reserve(table.size());
+    for (const auto& [key, value] : table) {
+        values.push_back(value);
+    }
+    SidecarBlobWriter blob;
+    blob.putArray(std::span<const V>(values));
+    return blob.take();
+}
+
+// the checkpoints are viewed in place
+GzipIndex loadGzipIndex(const Sidecar& sidecar) {
+    SidecarBlobReader blob(sidecar.bytes(SidecarSection::GZIP_INDEX));
+    GzipIndex         gzipIndex;
+    gzipIndex.uncompressedSize = blob.get<uint64_t>();
+    gzipIndex.checkpoints =
+        Column<GzipCheckpoint>::view(sidecar.section<GzipCheckpoint>(SidecarSection::GZIP_CHECKPOINTS));
+    return gzipIndex;
+}
+
+// of the window cache of a gzipped dump, unless --max-memory bounds it
+constexpr size_t DUMP_WINDOWS_BYTES = size_t{512} << 20;
+
 } // namespace
 
-void App::run(const Args& args) {
+void App::load(const Args& args) {
+    unload();
+    workerThreads = args.threads;
 
-    const auto bytes = readWholeFile(args.dumpFile);
+    auto       openPhase = stats.phase("open dump");
+    MappedFile file(args.dumpFile);
+    const bool gzipped = hasGzipMagic({file.data(), file.size()});
 
-    const std::string magic = "JAVA PROFILE 1.0.2";
+    // the header of a compressed dump is inflated on its own, as the index is looked up by it
+    const std::string magic        = "JAVA PROFILE 1.0.2";
+    const size_t      preambleSize = magic.size() + 1 + sizeof(uint32_t) + sizeof(uint64_t);
+    const auto        preamble =
+        gzipped ? gunzipPrefix(file, preambleSize)
+                : std::vector<std::byte>(file.data(), file.data() + std::min(file.size(), preambleSize));
 
-    if (std::strncmp(magic.c_str(), reinterpret_cast<const char*>(bytes.data()), bytes.size()) != 0) {
+    if (std::strncmp(magic.c_str(), reinterpret_cast<const char*>(preamble.data()), preamble.size()) != 0) {
         throw std::runtime_error("wrong dump format");
     }
 
-    R r(bytes.data(), bytes.size());
-    r.skip(magic.size() + 1);
+    R pr(preamble.data(), preamble.size());
+    pr.skip(magic.size() + 1);
 
-    const auto dumpHeader = parseDumpHeader(r);
-    identifierSize        = dumpHeader.identifierSize;
+    dumpHeader     = parseDumpHeader(pr);
+    identifierSize = dumpHeader.identifierSize;
 
     if (identifierSize > sizeof(ID)) {
         throw std::runtime_error(std::format("unsupported identifier size {}", identifierSize));
     }
-    const R dumpBodyReader = r;
+
+    indexPath = sidecarPath(args.dumpFile);
+    indexKey  = {file.size(), dumpHeader.millis, static_cast<uint32_t>(identifierSize)};
+    if (args.useIndex) {
+        sidecarIndex = Sidecar::open(indexPath, indexKey);
+    }
+    openPhase.finish();
+
+    // all parsed views point straight into this mapping, so it must outlive them;
+    // a gzipped dump is read through a cache of windows of its inflated contents instead,
+    // which are inflated from the checkpoints of the index, or streamed while the dump is parsed
+    dumpFile                  = std::move(file);
+    const size_t windowsBytes = args.maxMemoryBytes.has_value() ? *args.maxMemoryBytes / 4 : DUMP_WINDOWS_BYTES;
+
+    if (sidecarIndex.has_value()) {
+        auto indexPhase = stats.phase("load index");
+        try {
+            if (gzipped) {
+                dumpWindows.emplace(dumpFile, loadGzipIndex(*sidecarIndex), windowsBytes);
+            }
+            loadIndex(*sidecarIndex);
+        } catch (const std::runtime_error& e) {
+            // the dump is parsed instead, and a new index written in place of this one
+            std::cerr << std::format("warning: could not load index {}: {}\n", indexPath.string(), e.what());
+            clearTables();
+            dumpWindows.reset();
+            sidecarIndex.reset();
+        }
+        indexPhase.processed(0, dumpSummary.numRecords + dumpSummary.numSubtags);
+    }
+    if (!sidecarIndex.has_value()) {
+        auto parsePhase = stats.phase("parse dump");
+        dumpFile.advise(MappedFile::Advice::SEQUENTIAL);
+        if (gzipped) {
+            dumpWindows.emplace(dumpFile, windowsBytes);
+        }
+        R dumpBodyReader = dumpReader();
+        dumpBodyReader.skip(pr.offset());
+
+        std::optional<SpillOptions> spill;
+        if (args.maxMemoryBytes.has_value()) {
+            auto pathPrefix = args.dumpFile;
+            pathPrefix += ".spill";
+            spill = SpillOptions{std::move(pathPrefix), *args.maxMemoryBytes};
+        }
+
+        // order of records is not guaranteed, so everything is collected in one scan
+        // and cross-record lookups are only done once all tables are complete;
+        // the tables are allocated from the arena of the app, so moving them here takes constant time
+        auto dump          = parseDump(dumpBodyReader, identifierSize, workerThreads, spill, &tableArena, windows());
+        dumpSummary        = std::move(dump.summary);
+        recordDirectory    = std::move(dump.directory);
+        strings            = std::move(dump.strings);
+        loadClasses        = std::move(dump.loadClasses);
+        classDumps         = std::move(dump.classDumps);
+        classInstanceCount = std::move(dump.classInstanceCount);
+        objects            = std::move(dump.objects);
+        stackFrames        = std::move(dump.stackFrames);
+        stackTraces        = std::move(dump.stackTraces);
+        gcRoots            = std::move(dump.gcRoots);
+        spillFiles         = std::move(dump.spillFiles);
+        parsePhase.processed(dumpFile.size(), dumpSummary.numRecords + dumpSummary.numSubtags);
+    }
+    {
+        auto layoutPhase = stats.phase("class layouts");
+        classLayouts     = buildClassLayouts(classDumps, strings, identifierSize, &tableArena);
+        layoutPhase.processed(0, classDumps.size());
+    }
+
+    // from here on the dump is only accessed through point lookups
+    dumpFile.advise(MappedFile::Advice::RANDOM);
+}
+
+void App::unload() {
+    clearTables();
+    spillFiles.clear();
+    dumpWindows.reset();
+    sidecarIndex.reset();
+    dumpFile = MappedFile();
+}
+
+void App::clearTables() {
+    // graphs and object tables are flat arrays, or views of the index and spill files, so they go first
+    recentPins = {};
+    dominatorTree.reset();
+    rootPaths.reset();
+    inboundReferenceGraph.reset();
+    referenceGraph.reset();
+    shallowSizes = {};
+    gcRoots      = {};
+    objects      = {};
+
+    // deallocating into the arena frees nothing, the arena then frees its blocks all at once;
+    // the tables are only recreated after that, as even empty ones may hold memory of the arena
+    std::destroy_at(&strings);
+    std::destroy_at(&loadClasses);
+    std::destroy_at(&classDumps);
+    std::destroy_at(&classLayouts);
+    std::destroy_at(&classInstanceCount);
+    std::destroy_at(&stackFrames);
+    std::destroy_at(&stackTraces);
+    tableArena.release();
+    std::construct_at(&strings, &tableArena);
+    std::construct_at(&loadClasses, &tableArena);
+    std::construct_at(&classDumps, &tableArena);
+    std::construct_at(&classLayouts, &tableArena);
+    std::construct_at(&classInstanceCount, &tableArena);
+    std::construct_at(&stackFrames, &tableArena);
+    std::construct_at(&stackTraces, &tableArena);
+
+    dumpSummary     = {};
+    recordDirectory = {};
+    coroutineFields = {}; // resolved for the classes of the dump
+}
+
+void App::run(const Args& args) {
+    load(args);
 
 #if 1
-    dumpSummary = summarizeDump(dumpBodyReader, identifierSize);
     std::cout << std::format("\n"
                              "Heap Dump Summary:\n\n"
                              "Size of identifiers: {}\n"
@@ -90,16 +265,28 @@ void App::run(const Args& args) {
     printDumpSummary(dumpSummary);
 #endif
 
-    // order of records is not guaranteed, so parse in separate passes
-    strings             = parseStrings(dumpBodyReader, identifierSize);
-    classDumps          = parseClassDumps(dumpBodyReader, identifierSize);
-    classInstanceCount  = countInstances(dumpBodyReader, identifierSize);
-    loadClasses         = parseLoadClasses(dumpBodyReader, dumpHeader);
-    instances           = parseInstanceDumps(dumpBodyReader, identifierSize);
-    objectArrayDumps    = parseObjectArrayDumps(dumpBodyReader, identifierSize);
-    primitiveArrayDumps = parsePrimitiveArrayDumps(dumpBodyReader, identifierSize);
-    stackFrames         = parseStackFrames(dumpBodyReader, identifierSize);
-    stackTraces         = parseStackTraces(dumpBodyReader, identifierSize);
+    if (args.histogram || args.unreachable || args.referrersOf.has_value() || args.pathToRootsOf.has_value()) {
+        if (args.histogram) {
+            auto histogramPhase = stats.phase("histogram");
+            printHistogram(args.histogramTop, args.retainedSizes);
+            histogramPhase.processed(0, objects.size());
+        }
+        if (args.unreachable) {
+            auto reachabilityPhase = stats.phase("reachability");
+            printReachability(args.histogramTop);
+            reachabilityPhase.processed(0, objects.size());
+        }
+        if (args.referrersOf.has_value()) {
+            auto referrersPhase = stats.phase("referrers");
+            printReferrers(*args.referrersOf);
+        }
+        if (args.pathToRootsOf.has_value()) {
+            auto pathPhase = stats.phase("path to roots");
+            printPathToRoots(*args.pathToRootsOf);
+        }
+        finish(args);
+        return;
+    }
 
 #if 0
     for (const auto& [k, v] : stackTraces) {
@@ -111,7 +298,7 @@ void App::run(const Args& args) {
 #endif
 
 #if 0
-    const auto threads = parseRootThreads(dumpBodyReader, identifierSize);
+    const auto threads = parseRootThreads({dumpReader(), recordDirectory}, identifierSize);
 
     std::cout << "\nThreads:\n\n";
 
@@ -120,7 +307,7 @@ void App::run(const Args& args) {
         if (const auto nameV = getFieldValue(v.threadObjectID, "name"); isObjectID(nameV)) {
             if (const auto nameArr = getFieldValue(static_cast<ObjectID>(nameV), "value");
                 isPrimitiveArrayID(nameArr)) {
-                const auto nameBytes = primitiveArrayDumps.at(static_cast<ArrayObjectID>(nameArr)).elementsView;
+                const auto nameBytes = getPrimitiveArray(static_cast<ArrayObjectID>(nameArr)).elementsView;
                 name = std::string_view(static_cast<const char*>((void*)nameBytes.data()), nameBytes.size());
             }
         }
@@ -132,15 +319,22 @@ void App::run(const Args& args) {
     }
 #endif
 
+    auto       discoveryPhase     = stats.phase("coroutine discovery");
     const auto coroutineInstances = getCoroutineInstances();
+    discoveryPhase.processed(0, objects.size());
+    discoveryPhase.finish();
 
 #if 0
     std::cout << "\nCoroutines summary:\n\n";
     printCoroutinesList(coroutineInstances);
 #endif
 
-    std::cout << "\nHierarchy:\n\n";
-    printCoroutinesHierarchy(coroutineInstances);
+    {
+        auto hierarchyPhase = stats.phase("coroutine hierarchy");
+        std::cout << "\nHierarchy:\n\n";
+        printCoroutinesHierarchy(coroutineInstances);
+        hierarchyPhase.processed(0, coroutineInstances.size());
+    }
 
 #if 0
     for (const auto id : getCoroutineClasses()) {
@@ -149,7 +343,283 @@ void App::run(const Args& args) {
     }
 #endif
 
+    finish(args);
+}
+
+void App::finish(const Args& args) {
     std::cout.flush();
+    if (args.useIndex) {
+        auto indexPhase = stats.phase("update index");
+        updateIndex(indexPath, indexKey);
+    }
+    if (!args.stats && !args.statsJSONFile.has_value()) {
+        return;
+    }
+
+    stats.clearTables();
+    stats.addTable("strings", strings.size(), estimateMemoryBytes(strings));
+    stats.addTable("loadClasses", loadClasses.size(), estimateMemoryBytes(loadClasses));
+    size_t classDumpsBytes = estimateMemoryBytes(classDumps);
+    for (const auto& [id, cd] : classDumps) {
+        classDumpsBytes += cd.constants.capacity() * sizeof(ClassDump::Constant) +
+                           cd.statics.capacity() * sizeof(ClassDump::Static) +
+                           cd.fields.capacity() * sizeof(ClassDump::Field);
+    }
+    stats.addTable("classDumps", classDumps.size(), classDumpsBytes);
+    size_t classLayoutsBytes = estimateMemoryBytes(classLayouts);
+    for (const auto& [id, layout] : classLayouts) {
+        classLayoutsBytes += layout.fields.capacity() * sizeof(ClassLayout::Field);
+    }
+    stats.addTable("classLayouts", classLayouts.size(), classLayoutsBytes);
+    stats.addTable("classInstanceCount", classInstanceCount.size(), estimateMemoryBytes(classInstanceCount));
+    stats.addTable("objects", objects.size(), objects.memoryBytes());
+    stats.addTable("gcRoots", gcRoots.size(), gcRoots.memoryBytes());
+    stats.addTable("shallowSizes", shallowSizes.size(), shallowSizes.capacity() * sizeof(uint64_t));
+    if (referenceGraph.has_value()) {
+        stats.addTable("referenceGraph", referenceGraph->targets().size(), referenceGraph->memoryBytes());
+    }
+    if (inboundReferenceGraph.has_value()) {
+        stats.addTable(
+            "inboundReferenceGraph", inboundReferenceGraph->targets().size(), inboundReferenceGraph->memoryBytes());
+    }
+    if (rootPaths.has_value()) {
+        stats.addTable("rootPaths", rootPaths->size(), rootPaths->memoryBytes());
+    }
+    if (dominatorTree.has_value()) {
+        stats.addTable("dominatorTree", dominatorTree->size(), dominatorTree->memoryBytes());
+    }
+    size_t stackTracesBytes = estimateMemoryBytes(stackTraces);
+    for (const auto& [serial, trace] : stackTraces) {
+        stackTracesBytes += trace.stackFrames.capacity() * sizeof(StackFrameID);
+    }
+    stats.addTable("stackFrames", stackFrames.size(), estimateMemoryBytes(stackFrames));
+    stats.addTable("stackTraces", stackTraces.size(), stackTracesBytes);
+
+    if (args.stats) {
+        stats.print(std::cout);
+        std::cout.flush();
+    }
+    if (args.statsJSONFile.has_value()) {
+        std::ofstream fout;
+        fout.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        fout.open(*args.statsJSONFile, std::ios_base::out | std::ios_base::trunc);
+        stats.printJSON(fout);
+    }
+}
+
+void App::loadIndex(const Sidecar& sidecar) {
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::SUMMARY));
+        dumpSummary.numRecords = blob.get<size_t>();
+        dumpSummary.numSubtags = blob.get<size_t>();
+        for (const auto& [tag, count] : blob.getArray<CountOf<Tag>>()) {
+            dumpSummary.tagCounts[tag] = count;
+        }
+        for (const auto& [subTag, count] : blob.getArray<CountOf<SubTag>>()) {
+            dumpSummary.subTagCounts[subTag] = count;
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::RECORD_DIRECTORY));
+        const auto        numTags = blob.get<size_t>();
+        for (size_t i = 0; i < numTags; ++i) {
+            const auto tag               = blob.get<Tag>();
+            recordDirectory.records[tag] = blob.getArray<RecordLocation>();
+        }
+        recordDirectory.heapDumpSegments = blob.getArray<HeapDumpSegmentLocation>();
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::STRINGS));
+        const auto        savedStrings = blob.getArray<SavedString>();
+        const auto        contents     = dumpWindows.has_value()
+                                           ? sidecar.bytes(SidecarSection::STRING_CONTENTS)
+                                           : std::span<const std::byte>(dumpFile.data(), dumpFile.size());
+        strings.reserve(savedStrings.size());
+        for (const auto& [id, offset, size] : savedStrings) {
+            if (offset > contents.size() || contents.size() - offset < size) {
+                throw std::runtime_error("corrupt strings in index");
+            }
+            const std::string_view view(reinterpret_cast<const char*>(contents.data() + offset), size);
+            strings.emplace(id, StringInUTF8{id, view});
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::LOAD_CLASSES));
+        for (const auto& loadClass : blob.getArray<LoadClass>()) {
+            loadClasses.emplace(loadClass.classObjectID, loadClass);
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::CLASS_DUMPS));
+        const auto        numClasses = blob.get<size_t>();
+        const auto        allocator  = classDumps.get_allocator();
+        for (size_t i = 0; i < numClasses; ++i) {
+            ClassDump classDump(allocator);
+            classDump.classObjectID            = blob.get<ClassObjectID>();
+            classDump.stackTrackeSerialNumber  = blob.get<uint32_t>();
+            classDump.superclassObjectID       = blob.get<ClassObjectID>();
+            classDump.classLoaderObjectID      = blob.get<ID>();
+            classDump.signersObjectID          = blob.get<ID>();
+            classDump.protectionDomainObjectID = blob.get<ID>();
+            classDump.reserved[0]              = blob.get<ID>();
+            classDump.reserved[1]              = blob.get<ID>();
+            classDump.instanceSizeBytes        = blob.get<uint32_t>();
+            classDump.constants                = blob.getArray<ClassDump::Constant>(allocator);
+            classDump.statics                  = blob.getArray<ClassDump::Static>(allocator);
+            classDump.fields                   = blob.getArray<ClassDump::Field>(allocator);
+            classDumps.emplace(classDump.classObjectID, std::move(classDump));
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::CLASS_INSTANCE_COUNT));
+        for (const auto& [classObjectID, count] : blob.getArray<CountOf<ClassObjectID>>()) {
+            classInstanceCount.emplace(classObjectID, count);
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::STACK_FRAMES));
+        for (const auto& stackFrame : blob.getArray<StackFrame>()) {
+            stackFrames.emplace(stackFrame.stackFrameID, stackFrame);
+        }
+    }
+    {
+        SidecarBlobReader blob(sidecar.bytes(SidecarSection::STACK_TRACES));
+        const auto        numTraces = blob.get<size_t>();
+        const auto        allocator = stackTraces.get_allocator();
+        for (size_t i = 0; i < numTraces; ++i) {
+            StackTrace stackTrace(allocator);
+            stackTrace.stackTraceSerialNumber = blob.get<StackTraceSerialNumber>();
+            stackTrace.threadSerialNumber     = blob.get<uint32_t>();
+            stackTrace.numberOfFrames         = blob.get<uint32_t>();
+            stackTrace.stackFrames            = blob.getArray<StackFrameID>(allocator);
+            stackTraces.emplace(stackTrace.stackTraceSerialNumber, std::move(stackTrace));
+        }
+    }
+
+    objects        = ObjectDirectory::load(sidecar);
+    gcRoots        = GCRootTable::load(sidecar);
+    referenceGraph = ReferenceGraph::load(sidecar);
+    dominatorTree  = DominatorTree::load(sidecar);
+    if ((referenceGraph.has_value() && referenceGraph->numObjects() != objects.size()) ||
+        (dominatorTree.has_value() && dominatorTree->size() != objects.size())) {
+        throw std::runtime_error("graphs in index do not match the number of objects");
+    }
+}
+
+void App::updateIndex(const std::filesystem::path& path, const SidecarKey& key) {
+    const bool upToDate =
+        sidecarIndex.has_value() &&
+        (!referenceGraph.has_value() || sidecarIndex->contains(SidecarSection::REFERENCE_OFFSETS)) &&
+        (!dominatorTree.has_value() || sidecarIndex->contains(SidecarSection::IMMEDIATE_DOMINATORS)) &&
+        (!dumpWindows.has_value() || sidecarIndex->contains(SidecarSection::GZIP_CHECKPOINTS));
+    if (upToDate) {
+        return;
+    }
+
+    // the writer only copies the checkpoints on write
+    const GzipIndex gzipIndex = dumpWindows.has_value() ? dumpWindows->index() : GzipIndex{};
+    SidecarWriter   writer(key);
+    if (dumpWindows.has_value()) {
+        SidecarBlobWriter blob;
+        blob.put(gzipIndex.uncompressedSize);
+        writer.add(SidecarSection::GZIP_INDEX, blob.take());
+        writer.add(SidecarSection::GZIP_CHECKPOINTS, gzipIndex.checkpoints.span());
+    }
+    {
+        SidecarBlobWriter            blob;
+        std::vector<CountOf<Tag>>    tagCounts(dumpSummary.tagCounts.begin(), dumpSummary.tagCounts.end());
+        std::vector<CountOf<SubTag>> subTagCounts(dumpSummary.subTagCounts.begin(), dumpSummary.subTagCounts.end());
+        blob.put(dumpSummary.numRecords);
+        blob.put(dumpSummary.numSubtags);
+        blob.putArray(std::span<const CountOf<Tag>>(tagCounts));
+        blob.putArray(std::span<const CountOf<SubTag>>(subTagCounts));
+        writer.add(SidecarSection::SUMMARY, blob.take());
+    }
+    {
+        SidecarBlobWriter blob;
+        blob.put(recordDirectory.records.size());
+        for (const auto& [tag, locations] : recordDirectory.records) {
+            blob.put(tag);
+            blob.putArray(std::span(locations));
+        }
+        blob.putArray(std::span(recordDirectory.heapDumpSegments));
+        writer.add(SidecarSection::RECORD_DIRECTORY, blob.take());
+    }
+    {
+        std::vector<SavedString> savedStrings;
+        std::vector<std::byte>   contents;
+        savedStrings.reserve(strings.size());
+        for (const auto& [id, string] : strings) {
+            const auto* data   = reinterpret_cast<const std::byte*>(string.view.data());
+            uint64_t    offset = contents.size();
+            if (dumpWindows.has_value()) {
+                contents.insert(contents.end(), data, data + string.view.size());
+            } else {
+                offset = static_cast<uint64_t>(data - dumpFile.data());
+            }
+            savedStrings.push_back({id, offset, string.view.size()});
+        }
+        SidecarBlobWriter blob;
+        blob.putArray(std::span(savedStrings));
+        writer.add(SidecarSection::STRINGS, blob.take());
+        if (dumpWindows.has_value()) {
+            writer.add(SidecarSection::STRING_CONTENTS, std::move(contents));
+        }
+    }
+    writer.add(SidecarSection::LOAD_CLASSES, packValues(loadClasses));
+    {
+        SidecarBlobWriter blob;
+        blob.put(classDumps.size());
+        for (const auto& [classObjectID, classDump] : classDumps) {
+            blob.put(classDump.classObjectID);
+            blob.put(classDump.stackTrackeSerialNumber);
+            blob.put(classDump.superclassObjectID);
+            blob.put(classDump.classLoaderObjectID);
+            blob.put(classDump.signersObjectID);
+            blob.put(classDump.protectionDomainObjectID);
+            blob.put(classDump.reserved[0]);
+            blob.put(classDump.reserved[1]);
+            blob.put(classDump.instanceSizeBytes);
+            blob.putArray(std::span(classDump.constants));
+            blob.putArray(std::span(classDump.statics));
+            blob.putArray(std::span(classDump.fields));
+        }
+        writer.add(SidecarSection::CLASS_DUMPS, blob.take());
+    }
+    {
+        std::vector<CountOf<ClassObjectID>> counts(classInstanceCount.begin(), classInstanceCount.end());
+        SidecarBlobWriter                   blob;
+        blob.putArray(std::span<const CountOf<ClassObjectID>>(counts));
+        writer.add(SidecarSection::CLASS_INSTANCE_COUNT, blob.take());
+    }
+    writer.add(SidecarSection::STACK_FRAMES, packValues(stackFrames));
+    {
+        SidecarBlobWriter blob;
+        blob.put(stackTraces.size());
+        for (const auto& [serialNumber, stackTrace] : stackTraces) {
+            blob.put(stackTrace.stackTraceSerialNumber);
+            blob.put(stackTrace.threadSerialNumber);
+            blob.put(stackTrace.numberOfFrames);
+            blob.putArray(std::span(stackTrace.stackFrames));
+        }
+        writer.add(SidecarSection::STACK_TRACES, blob.take());
+    }
+
+    objects.save(writer);
+    gcRoots.save(writer);
+    if (referenceGraph.has_value()) {
+        referenceGraph->save(writer);
+    }
+    if (dominatorTree.has_value()) {
+        dominatorTree->save(writer);
+    }
+
+    // the index is only a cache, so failing to write it is not fatal
+    try {
+        writer.write(path);
+    } catch (const std::exception& e) {
+        std::cerr << std::format("warning: could not write index {}: {}\n", path.string(), e.what());
+    }
 }
 
 void App::printInstance(ObjectID objectID, bool recurse, size_t indent, std::string_view name) {
@@ -161,7 +631,7 @@ void App::printInstance(ObjectID objectID, bool recurse, size_t indent, std::str
                 std::cout << indentStr << "null object " << name_ << '\n';
                 return;
             }
-            const auto& instance  = instances.at(objectID_);
+            const auto  instance  = getInstance(objectID_);
             const auto& loadClass = loadClasses.at(instance.classObjectID);
             const auto  className = getView(loadClass.nameStringID);
             std::cout << indentStr
@@ -183,8 +653,9 @@ void App::printInstance(ObjectID objectID, bool recurse, size_t indent, std::str
             forEachField(objectID_, [&](ClassDump::Field f, Value v) {
                 const auto fieldName = getView(f.nameStringID);
                 if (f.type == BasicType::OBJECT) {
-                    const ID id = static_cast<ID>(v);
-                    if (isObjectID(id)) {
+                    const ID   id   = static_cast<ID>(v);
+                    const auto kind = objects.kind(id);
+                    if (kind == ObjectKind::INSTANCE) {
                         f_(static_cast<ObjectID>(id), indent_ + 2, fieldName, f_);
                         return;
                     }
@@ -192,12 +663,8 @@ void App::printInstance(ObjectID objectID, bool recurse, size_t indent, std::str
                     std::cout << indentStr << "  ";
                     if (isNull(id)) {
                         std::cout << "null";
-                    } else if (isClassObjectID(id)) {
-                        std::cout << "class";
-                    } else if (isObjectArrayID(id)) {
-                        std::cout << "object array";
-                    } else if (isPrimitiveArrayID(id)) {
-                        std::cout << "primitive array";
+                    } else if (kind != ObjectKind::NONE) {
+                        std::cout << objectKindName(kind);
                     } else {
                         throw std::runtime_error("unknown object");
                     }
@@ -235,7 +702,6 @@ void App::printStackFrame(StackFrameID frameID, size_t indent) {
     std::cout << '\n';
 }
 
-// TODO
 size_t App::calcRetainedHeapSize(isID auto root_) {
     const ID root = static_cast<ID>(root_);
 
@@ -243,63 +709,137 @@ size_t App::calcRetainedHeapSize(isID auto root_) {
         return 0;
     }
 
-    size_t                 retainedHeapSize = basicTypeSize(BasicType::OBJECT);
-    std::unordered_set<ID> visited;
-    std::stack<ID>         toVisit;
+    const auto index = objects.indexOf(root);
+    if (index == NO_OBJECT) {
+        throw std::runtime_error(std::format("could not resolve object ID {}", formatID(root)));
+    }
+    return getDominatorTree().retainedSize(index);
+}
+
+uint64_t App::getShallowSize(ObjectIndex index) {
+    // called from parallel loops, so the windows of the object are only held while it is read
+    const auto           location = objects.location(index);
+    GzipWindowCache::Pin pin;
+    switch (location.kind) {
+        using enum ObjectKind;
+    case INSTANCE: {
+        R r = getObjectReader(location, pin);
+        return classDumps.at(parseInstanceDump(r, identifierSize).classObjectID).instanceSizeBytes;
+    }
+    case OBJECT_ARRAY: {
+        R r = getObjectReader(location, pin);
+        return uint64_t{identifierSize} * parseObjectArrayDump(r, identifierSize).numberOfElements;
+    }
+    case PRIMITIVE_ARRAY: {
+        R          r     = getObjectReader(location, pin);
+        const auto array = parsePrimitiveArrayDump(r, identifierSize);
+        return uint64_t{basicTypeSize(array.elementType, identifierSize)} * array.numberOfElements;
+    }
+    case CLASS: return 0;
+    case NONE:  break;
+    }
+    throw std::runtime_error("unreachable code");
+}
 
-    toVisit.push(root);
-    visited.insert(root);
-    while (!toVisit.empty()) {
-        const auto id = toVisit.top();
-        toVisit.pop();
+const std::vector<uint64_t>& App::getShallowSizes() {
+    if (shallowSizes.size() == objects.size()) {
+        return shallowSizes;
+    }
 
-        if (isObjectID(id)) {
-            const auto objectID = static_cast<ObjectID>(id);
-            retainedHeapSize += classDumps.at(instances.at(objectID).classObjectID).instanceSizeBytes;
-            forEachField(objectID, [&](ClassDump::Field f, Value v) {
-                if (f.type == BasicType::OBJECT) {
-                    const ID fieldID = static_cast<ID>(v);
-                    if (!isNull(fieldID) && !visited.contains(fieldID)) {
-                        visited.insert(fieldID);
-                        toVisit.push(fieldID);
-                    }
-                }
-            });
-            continue;
+    auto             sizesPhase = stats.phase("shallow sizes");
+    constexpr size_t BLOCK_SIZE = size_t{1} << 16;
+    shallowSizes.resize(objects.size());
+    parallelFor((objects.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, workerThreads, [&](size_t block, size_t) {
+        const size_t end = std::min(objects.size(), (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+            shallowSizes[i] = getShallowSize(static_cast<ObjectIndex>(i));
         }
+    });
+    sizesPhase.processed(0, objects.size());
+    return shallowSizes;
+}
 
-        if (isObjectArrayID(id)) {
-            const auto  objectArrayID = static_cast<ArrayObjectID>(id);
-            const auto& array         = objectArrayDumps.at(objectArrayID);
-            retainedHeapSize += identifierSize * array.numberOfElements;
-            R r(array.elementsView.data(), array.elementsView.size_bytes());
-            for (size_t i = 0; i < array.numberOfElements; ++i) {
-                const ID elementID = r.read<ID>(identifierSize);
-                if (!isNull(elementID) && !visited.contains(elementID)) {
-                    visited.insert(elementID);
-                    toVisit.push(elementID);
-                }
-            }
-            continue;
-        }
+std::string_view App::getClassName(ClassObjectID classObjectID) {
+    const auto it = loadClasses.find(classObjectID);
+    return it != loadClasses.end() ? getView(it->second.nameStringID) : "<unknown class>";
+}
 
-        if (isPrimitiveArrayID(id)) {
-            const auto  primitiveArrayID = static_cast<ArrayObjectID>(id);
-            const auto& array            = primitiveArrayDumps.at(primitiveArrayID);
-            retainedHeapSize += basicTypeSize(array.elementType) * array.numberOfElements;
-            continue;
-        }
+std::string_view App::getObjectClassName(ObjectIndex index) {
+    // called from parallel loops, as getShallowSize
+    const auto           location = objects.location(index);
+    GzipWindowCache::Pin pin;
+    switch (location.kind) {
+        using enum ObjectKind;
+    case INSTANCE: {
+        R r = getObjectReader(location, pin);
+        return getClassName(parseInstanceDump(r, identifierSize).classObjectID);
+    }
+    case OBJECT_ARRAY: {
+        R          r     = getObjectReader(location, pin);
+        const auto array = parseObjectArrayDump(r, identifierSize);
+        return getClassName(static_cast<ClassObjectID>(static_cast<ID>(array.arrayClassObjectID)));
+    }
+    case PRIMITIVE_ARRAY: {
+        R r = getObjectReader(location, pin);
+        return basicTypeArrayName(parsePrimitiveArrayDump(r, identifierSize).elementType);
+    }
+    case CLASS: return "java/lang/Class";
+    case NONE:  break;
+    }
+    throw std::runtime_error("unreachable code");
+}
 
-        if (isClassObjectID(id)) {
-            // TODO
-            retainedHeapSize += 0;
-            continue;
+const ReferenceGraph& App::getReferenceGraph() {
+    if (!referenceGraph.has_value()) {
+        auto graphPhase = stats.phase("reference graph");
+        referenceGraph  = buildReferenceGraph(
+            dumpReader(), identifierSize, objects, classLayouts, classDumps, workerThreads, windows());
+        graphPhase.processed(0, objects.size());
+    }
+    return *referenceGraph;
+}
+
+const ReferenceGraph& App::getInboundReferenceGraph() {
+    if (!inboundReferenceGraph.has_value()) {
+        const auto& graph      = getReferenceGraph();
+        auto        graphPhase = stats.phase("inbound reference graph");
+        inboundReferenceGraph  = transposeReferenceGraph(graph, workerThreads);
+        graphPhase.processed(0, graph.targets().size());
+    }
+    return *inboundReferenceGraph;
+}
+
+std::vector<ObjectIndex> App::getRootIndices() {
+    std::vector<ObjectIndex> roots;
+    for (const auto id : gcRoots.ids()) {
+        if (const auto index = objects.indexOf(id); index != NO_OBJECT) {
+            roots.push_back(index);
         }
+    }
+    return roots;
+}
 
-        throw std::runtime_error(std::format("could not resolve object ID {}", id));
+const RootPaths& App::getRootPaths() {
+    if (!rootPaths.has_value()) {
+        const auto& graph     = getReferenceGraph();
+        auto        pathPhase = stats.phase("root paths");
+        rootPaths.emplace(graph, getRootIndices());
+        pathPhase.processed(0, objects.size());
     }
+    return *rootPaths;
+}
 
-    return retainedHeapSize;
+const DominatorTree& App::getDominatorTree() {
+    if (dominatorTree.has_value()) {
+        return *dominatorTree;
+    }
+
+    const auto& graph          = getReferenceGraph();
+    const auto& sizes          = getShallowSizes();
+    auto        dominatorPhase = stats.phase("dominator tree");
+    dominatorTree.emplace(graph.offsets(), graph.targets(), getRootIndices(), sizes);
+    dominatorPhase.processed(0, objects.size());
+    return *dominatorTree;
 }
 
 void App::forEachSuperclass(ClassObjectID classObjectID, std::function<void(ClassObjectID)> f) {
@@ -318,29 +858,84 @@ void App::forEachField(ClassObjectID classObjectID, std::function<void(ClassDump
 }
 
 void App::forEachField(ObjectID objectID, std::function<void(ClassDump::Field, Value)> f) {
-    const auto& instance = instances.at(objectID);
-    R           fieldsReader(instance.fieldsView.data(), instance.fieldsView.size_bytes());
-    forEachSuperclass(instance.classObjectID, [&](ClassObjectID id) {
-        for (const auto& field : classDumps.at(id).fields) {
-            f(field, fieldsReader.read<Value>(basicTypeSize(field.type)));
-        }
-    });
+    // all values are read before f looks up other objects, which may release the windows of this one
+    const auto                                      instance = getInstance(objectID);
+    std::vector<std::pair<ClassDump::Field, Value>> fields;
+    for (const auto& field : getInstanceLayout(instance).fields) {
+        fields.emplace_back(ClassDump::Field{field.nameStringID, field.ref.type},
+                            readField(instance.fieldsView, field.ref));
+    }
+    for (const auto& [field, value] : fields) {
+        f(field, value);
+    }
 }
 
 bool App::isClassObjectID(ID id) {
-    return classDumps.contains(static_cast<ClassObjectID>(id));
+    return objects.kind(id) == ObjectKind::CLASS;
 }
 
 bool App::isObjectID(ID id) {
-    return instances.contains(static_cast<ObjectID>(id));
+    return objects.kind(id) == ObjectKind::INSTANCE;
 }
 
 bool App::isObjectArrayID(ID id) {
-    return objectArrayDumps.contains(static_cast<ArrayObjectID>(id));
+    return objects.kind(id) == ObjectKind::OBJECT_ARRAY;
 }
 
 bool App::isPrimitiveArrayID(ID id) {
-    return primitiveArrayDumps.contains(static_cast<ArrayObjectID>(id));
+    return objects.kind(id) == ObjectKind::PRIMITIVE_ARRAY;
+}
+
+R App::getSubRecordReader(ID id, ObjectKind kind) {
+    const auto location = objects.find(id);
+    if (!location.has_value() || location->kind != kind) {
+        throw std::runtime_error(std::format("could not resolve {} ID {}", objectKindName(kind), formatID(id)));
+    }
+    GzipWindowCache::Pin pin;
+    R                    r = getObjectReader(*location, pin);
+    if (dumpWindows.has_value()) {
+        std::lock_guard lock(recentPinsMutex);
+        recentPins[nextRecentPin++ % recentPins.size()] = std::move(pin);
+    }
+    return r;
+}
+
+R App::getObjectReader(ObjectLocation location, GzipWindowCache::Pin& pin) {
+    return objectDumpReader(dumpReader(), location, identifierSize, windows(), pin);
+}
+
+R App::dumpReader() {
+    return dumpWindows.has_value() ? R(dumpWindows->data(), dumpWindows->size()) : R(dumpFile.data(), dumpFile.size());
+}
+
+GzipWindowCache* App::windows() {
+    return dumpWindows.has_value() ? &*dumpWindows : nullptr;
+}
+
+InstanceDump App::getInstance(ObjectID objectID) {
+    R r = getSubRecordReader(static_cast<ID>(objectID), ObjectKind::INSTANCE);
+    return parseInstanceDump(r, identifierSize);
+}
+
+ObjectArrayDump App::getObjectArray(ArrayObjectID arrayObjectID) {
+    R r = getSubRecordReader(static_cast<ID>(arrayObjectID), ObjectKind::OBJECT_ARRAY);
+    return parseObjectArrayDump(r, identifierSize);
+}
+
+PrimitiveArrayDump App::getPrimitiveArray(ArrayObjectID arrayObjectID) {
+    R r = getSubRecordReader(static_cast<ID>(arrayObjectID), ObjectKind::PRIMITIVE_ARRAY);
+    return parsePrimitiveArrayDump(r, identifierSize);
+}
+
+void App::forEachInstance(std::function<void(const InstanceDump&)> f) {
+    objects.forEach([&](ObjectIndex index) {
+        const auto location = objects.location(index);
+        if (location.kind == ObjectKind::INSTANCE) {
+            GzipWindowCache::Pin pin;
+            R                    r = getObjectReader(location, pin);
+            f(parseInstanceDump(r, identifierSize));
+        }
+    });
 }
 
 std::vector<ObjectID> App::getClassInstances(ClassObjectID classObjectID) {
@@ -348,11 +943,11 @@ std::vector<ObjectID> App::getClassInstances(ClassObjectID classObjectID) {
         return {};
     }
     std::vector<ObjectID> classInstances;
-    for (const auto& [id, i] : instances) {
+    forEachInstance([&](const InstanceDump& i) {
         if (i.classObjectID == classObjectID) {
-            classInstances.push_back(id);
+            classInstances.push_back(i.objectID);
         }
-    }
+    });
     return classInstances;
 }
 
@@ -382,11 +977,11 @@ std::unordered_set<ClassObjectID> App::getCoroutineClasses(bool internal) {
 std::unordered_set<ObjectID> App::getCoroutineInstances() {
     const auto&                  coroutineClasses = getCoroutineClasses();
     std::unordered_set<ObjectID> coroutineInstances;
-    for (const auto& [id, i] : instances) {
+    forEachInstance([&](const InstanceDump& i) {
         if (coroutineClasses.contains(i.classObjectID)) {
-            coroutineInstances.insert(id);
+            coroutineInstances.insert(i.objectID);
         }
-    }
+    });
     return coroutineInstances;
 }
 
@@ -396,24 +991,41 @@ void App::printCoroutinesList(const std::unordered_set<ObjectID>& coroutinesList
     }
 }
 
-Value App::getFieldValue(ObjectID id, std::string_view fieldName) {
-    Value value;
-    bool  found = false;
-    forEachField(id, [&](ClassDump::Field f, Value v) {
-        if (!found && getView(f.nameStringID) == fieldName) {
-            found = true;
-            value = v;
-        }
-    });
-    if (!found) {
+const ClassLayout& App::getInstanceLayout(const InstanceDump& instance) {
+    const auto& layout = classLayouts.at(instance.classObjectID);
+    if (instance.fieldsView.size_bytes() < layout.fieldsByteSize) {
+        throw std::runtime_error(std::format("instance {} is too small for its class", formatID(instance.objectID)));
+    }
+    return layout;
+}
+
+Value App::getFieldValue(const InstanceDump& instance, std::string_view fieldName) {
+    const auto fieldRef = getInstanceLayout(instance).find(fieldName);
+    if (!fieldRef.has_value()) {
         throw std::runtime_error(std::format("could not find field {}", fieldName));
     }
-    return value;
+    return readField(instance.fieldsView, *fieldRef);
+}
+
+Value App::getFieldValue(ObjectID id, std::string_view fieldName) {
+    return getFieldValue(getInstance(id), fieldName);
+}
+
+Value App::getFieldValue(const InstanceDump& instance, FieldHandle& field) {
+    const auto fieldRef = field.resolve(instance.classObjectID, getInstanceLayout(instance));
+    if (!fieldRef.has_value()) {
+        throw std::runtime_error(std::format("could not find field {}", field.name()));
+    }
+    return readField(instance.fieldsView, *fieldRef);
+}
+
+Value App::getFieldValue(ObjectID id, FieldHandle& field) {
+    return getFieldValue(getInstance(id), field);
 }
 
 std::string App::getCoroutineState(ObjectID id) {
-    const auto  stateObjectID  = static_cast<ObjectID>(getFieldValue(id, "_state$volatile"));
-    const auto& stateInstance  = instances.at(stateObjectID);
+    const auto  stateObjectID  = static_cast<ObjectID>(getFieldValue(id, coroutineFields.state));
+    const auto  stateInstance  = getInstance(stateObjectID);
     const auto& stateClass     = loadClasses.at(stateInstance.classObjectID);
     const auto  stateClassName = getView(stateClass.nameStringID);
 
@@ -441,7 +1053,7 @@ std::string App::getCoroutineState(ObjectID id) {
     }
 
     if (stateClassName == "kotlinx/coroutines/Empty") {
-        const bool isActive = static_cast<uint8_t>(getFieldValue(stateObjectID, "isActive"));
+        const bool isActive = static_cast<uint8_t>(getFieldValue(stateInstance, coroutineFields.isActive));
         if (isActive) {
             return "ACTIVE";
         } else {
@@ -450,7 +1062,7 @@ std::string App::getCoroutineState(ObjectID id) {
     }
 
     if (stateClassName == "kotlinx/coroutines/JobSupport$Finishing") {
-        const bool isCompleting = static_cast<int32_t>(getFieldValue(stateObjectID, "_isCompleting$volatile"));
+        const bool isCompleting = static_cast<int32_t>(getFieldValue(stateInstance, coroutineFields.isCompleting));
         if (isCompleting) {
             return "COMPLETING";
         } else {
@@ -548,27 +1160,27 @@ void App::printClass(ClassObjectID classObjectID) {
 }
 
 std::string App::formatInstance(ObjectID id, std::string_view name) {
-    const auto& instance  = instances.at(id);
+    const auto  instance  = getInstance(id);
     const auto& loadClass = loadClasses.at(instance.classObjectID);
     const auto  className = getView(loadClass.nameStringID);
     return std::format("{} {} = {}", className, name, formatID(id));
 }
 
 std::string App::formatCoroutine(ObjectID id) {
-    const auto& instance  = instances.at(id);
+    const auto  instance  = getInstance(id);
     const auto& loadClass = loadClasses.at(instance.classObjectID);
     const auto  className = getView(loadClass.nameStringID).substr(19);
     return std::format("{}@{}, state: {}", className, formatID(id), getCoroutineState(id));
 }
 
 std::optional<ObjectID> App::getCoroutineParent(ObjectID coroutine) {
-    const ID maybeParentHandleID = getFieldValue(coroutine, "_parentHandle$volatile");
+    const ID maybeParentHandleID = getFieldValue(coroutine, coroutineFields.parentHandle);
     if (!isObjectID(maybeParentHandleID)) {
         return std::nullopt;
     }
     const auto parentHandleID = static_cast<ObjectID>(maybeParentHandleID);
 
-    const auto& parentHandle          = instances.at(parentHandleID);
+    const auto  parentHandle          = getInstance(parentHandleID);
     const auto& parentHandleClass     = loadClasses.at(parentHandle.classObjectID);
     const auto  parentHandleClassName = getView(parentHandleClass.nameStringID);
 
@@ -576,7 +1188,7 @@ std::optional<ObjectID> App::getCoroutineParent(ObjectID coroutine) {
         return std::nullopt;
     }
 
-    const auto maybeParentJobID = getFieldValue(parentHandleID, "job");
+    const auto maybeParentJobID = getFieldValue(parentHandle, coroutineFields.job);
     if (!isObjectID(maybeParentJobID)) {
         return std::nullopt;
     }
@@ -642,3 +1254,325 @@ void App::printCoroutinesHierarchy(const std::unordered_set<ObjectID>& coroutine
         }
     });
 }
+
+std::string App::formatObject(ObjectIndex index) {
+    const ID id = objects.id(index);
+    switch (objects.kind(index)) {
+        using enum ObjectKind;
+    case INSTANCE:
+    case OBJECT_ARRAY:    return std::format("{} {}", getObjectClassName(index), formatID(id));
+    case PRIMITIVE_ARRAY: {
+        const auto array = getPrimitiveArray(static_cast<ArrayObjectID>(id));
+        return std::format("{}[{}] {}", basicTypeName(array.elementType), array.numberOfElements, formatID(id));
+    }
+    case CLASS: return std::format("class {} {}", getClassName(static_cast<ClassObjectID>(id)), formatID(id));
+    case NONE:  break;
+    }
+    throw std::runtime_error("unreachable code");
+}
+
+std::string App::formatReference(ObjectIndex from, ObjectIndex to) {
+    const ID    fromID = objects.id(from);
+    const ID    toID   = objects.id(to);
+    std::string names;
+    const auto  add = [&](std::string_view name) {
+        if (!names.empty()) {
+            names += ", ";
+        }
+        names += name;
+    };
+    switch (objects.kind(from)) {
+        using enum ObjectKind;
+    case INSTANCE: {
+        const auto instance = getInstance(static_cast<ObjectID>(fromID));
+        for (const auto& field : getInstanceLayout(instance).fields) {
+            if (field.ref.type == BasicType::OBJECT && readField(instance.fieldsView, field.ref) == toID) {
+                add(field.name);
+            }
+        }
+        break;
+    }
+    case OBJECT_ARRAY: {
+        const auto array = getObjectArray(static_cast<ArrayObjectID>(fromID));
+        size_t     i     = 0;
+        forEachBigEndianID(array.elementsView, identifierSize, [&](ID id) {
+            if (id == toID) {
+                add(std::format("[{}]", i));
+            }
+            ++i;
+        });
+        break;
+    }
+    case CLASS: {
+        for (const auto& s : classDumps.at(static_cast<ClassObjectID>(fromID)).statics) {
+            if (s.type == BasicType::OBJECT && static_cast<ID>(s.value) == toID) {
+                add(std::format("static {}", getView(s.nameStringID)));
+            }
+        }
+        break;
+    }
+    case PRIMITIVE_ARRAY:
+    case NONE:            break;
+    }
+    return names;
+}
+
+void App::printReferrers(ID id) {
+    const auto index = objects.indexOf(id);
+    if (index == NO_OBJECT) {
+        throw std::runtime_error(std::format("could not resolve object ID {}", formatID(id)));
+    }
+
+    // referrers are sorted, one referencing the object through several fields or slots is listed once
+    const auto               references = getInboundReferenceGraph().references(index);
+    std::vector<ObjectIndex> referrers(references.begin(), references.end());
+    referrers.erase(std::unique(referrers.begin(), referrers.end()), referrers.end());
+
+    std::cout << std::format("\nReferrers of {} ({}):\n\n", formatObject(index), referrers.size());
+    for (const auto referrer : referrers) {
+        std::cout << std::format("  {} via {}\n", formatObject(referrer), formatReference(referrer, index));
+    }
+}
+
+std::string App::formatGCRoots(ID id) {
+    std::string roots;
+    for (size_t i = 0; i < gcRoots.size(); ++i) {
+        if (gcRoots.id(i) != id) {
+            continue;
+        }
+        if (!roots.empty()) {
+            roots += ", ";
+        }
+        roots += subTagName(gcRoots.kind(i));
+        if (const auto thread = gcRoots.threadSerialNumber(i); thread != GCRootTable::NONE) {
+            roots += std::format(" thread={}", thread);
+        }
+        if (const auto frame = gcRoots.frameNumber(i); frame != GCRootTable::NONE) {
+            roots += std::format(" frame={}", frame);
+        }
+    }
+    return roots;
+}
+
+void App::printPathToRoots(ID id) {
+    const auto index = objects.indexOf(id);
+    if (index == NO_OBJECT) {
+        throw std::runtime_error(std::format("could not resolve object ID {}", formatID(id)));
+    }
+
+    const auto path = getRootPaths().pathFromRoot(index);
+    std::cout << std::format("\nShortest path from GC roots to {}:\n\n", formatObject(index));
+    if (path.empty()) {
+        std::cout << "  unreachable\n";
+        return;
+    }
+    std::cout << std::format("  {} ({})\n", formatObject(path.front()), formatGCRoots(objects.id(path.front())));
+    for (size_t i = 1; i < path.size(); ++i) {
+        std::cout << std::format(
+            "  {:{}}-> {}: {}\n", "", 2 * (i - 1), formatReference(path[i - 1], path[i]), formatObject(path[i]));
+    }
+}
+
+void App::printReachability(size_t top) {
+    struct ClassReachability {
+        size_t   reachable        = 0;
+        uint64_t reachableBytes   = 0;
+        size_t   unreachable      = 0;
+        uint64_t unreachableBytes = 0;
+    };
+    using Totals = std::unordered_map<std::string_view, ClassReachability>;
+
+    const auto& sizes = getShallowSizes();
+    const auto  marks = markReachable(getReferenceGraph(), getRootIndices(), workerThreads);
+
+    constexpr size_t    BLOCK_SIZE = size_t{1} << 16;
+    std::vector<Totals> perThreadTotals(workerThreads);
+    parallelFor((objects.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, workerThreads, [&](size_t block, size_t thread) {
+        auto&        totals = perThreadTotals[thread];
+        const size_t end    = std::min(objects.size(), (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+            auto& t = totals[getObjectClassName(static_cast<ObjectIndex>(i))];
+            if (marks.test(i)) {
+                ++t.reachable;
+                t.reachableBytes += sizes[i];
+            } else {
+                ++t.unreachable;
+                t.unreachableBytes += sizes[i];
+            }
+        }
+    });
+
+    Totals            totals;
+    ClassReachability all;
+    for (const auto& partial : perThreadTotals) {
+        for (const auto& [name, t] : partial) {
+            auto& dst = totals[name];
+            dst.reachable += t.reachable;
+            dst.reachableBytes += t.reachableBytes;
+            dst.unreachable += t.unreachable;
+            dst.unreachableBytes += t.unreachableBytes;
+            all.reachable += t.reachable;
+            all.reachableBytes += t.reachableBytes;
+            all.unreachable += t.unreachable;
+            all.unreachableBytes += t.unreachableBytes;
+        }
+    }
+
+    std::cout << std::format("\nReachability:\n\n"
+                             "reachable:   {} objects, {} bytes\n"
+                             "unreachable: {} objects, {} bytes\n",
+                             all.reachable,
+                             all.reachableBytes,
+                             all.unreachable,
+                             all.unreachableBytes);
+
+    std::vector<std::pair<std::string_view, ClassReachability>> garbage;
+    for (const auto& [name, t] : totals) {
+        if (t.unreachable > 0) {
+            garbage.emplace_back(name, t);
+        }
+    }
+    if (garbage.empty()) {
+        return;
+    }
+    const size_t numGarbageClasses = garbage.size();
+    top                            = std::min(top, numGarbageClasses);
+    std::partial_sort(garbage.begin(), garbage.begin() + top, garbage.end(), [](const auto& a, const auto& b) {
+        return std::tie(b.second.unreachableBytes, a.first) < std::tie(a.second.unreachableBytes, b.first);
+    });
+    garbage.resize(top);
+
+    size_t maxNameWidth = 5;
+    for (const auto& [name, t] : garbage) {
+        maxNameWidth = std::max(maxNameWidth, name.size());
+    }
+
+    std::cout << std::format("\nClasses with unreachable objects (top {} of {}):\n", top, numGarbageClasses);
+    std::cout << std::format("\n{:{}} | {:>11} | {:>17} | {:>11} | {:>17}\n",
+                             "class",
+                             maxNameWidth,
+                             "unreachable",
+                             "unreachable bytes",
+                             "reachable",
+                             "reachable bytes");
+    std::cout << std::format("{:-<{}}-+-{:-<11}-+-{:-<17}-+-{:-<11}-+-{:-<17}\n", "", maxNameWidth, "", "", "", "");
+    for (const auto& [name, t] : garbage) {
+        std::cout << std::format("{:{}} | {:>11} | {:>17} | {:>11} | {:>17}\n",
+                                 name,
+                                 maxNameWidth,
+                                 t.unreachable,
+                                 t.unreachableBytes,
+                                 t.reachable,
+                                 t.reachableBytes);
+    }
+}
+
+void App::printHistogram(size_t top, bool withRetainedSizes) {
+    struct ClassHistogram {
+        size_t   objects       = 0;
+        uint64_t shallowBytes  = 0; // of instances
+        uint64_t arrayBytes    = 0; // of array elements
+        uint64_t retainedBytes = 0;
+
+        uint64_t bytes() const {
+            return shallowBytes + arrayBytes;
+        }
+    };
+    using Histogram = std::unordered_map<std::string_view, ClassHistogram>;
+
+    const DominatorTree* dominators = withRetainedSizes ? &getDominatorTree() : nullptr;
+
+    constexpr size_t       BLOCK_SIZE = size_t{1} << 16;
+    std::vector<Histogram> perThreadHistograms(workerThreads);
+    parallelFor((objects.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, workerThreads, [&](size_t block, size_t thread) {
+        auto&        histogram = perThreadHistograms[thread];
+        const size_t end       = std::min(objects.size(), (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+            const auto     index = static_cast<ObjectIndex>(i);
+            const uint64_t size  = getShallowSize(index);
+            auto&          h     = histogram[getObjectClassName(index)];
+            ++h.objects;
+            if (objects.kind(index) == ObjectKind::INSTANCE) {
+                h.shallowBytes += size;
+            } else {
+                h.arrayBytes += size;
+            }
+        }
+    });
+
+    Histogram      histogram;
+    ClassHistogram all;
+    for (const auto& partial : perThreadHistograms) {
+        for (const auto& [name, h] : partial) {
+            auto& dst = histogram[name];
+            dst.objects += h.objects;
+            dst.shallowBytes += h.shallowBytes;
+            dst.arrayBytes += h.arrayBytes;
+            all.objects += h.objects;
+            all.shallowBytes += h.shallowBytes;
+            all.arrayBytes += h.arrayBytes;
+        }
+    }
+
+    if (dominators != nullptr) {
+        // classes are numbered so that the dominator tree can be walked with a counter per class
+        std::unordered_map<std::string_view, uint32_t> classNumbers;
+        for (const auto& [name, h] : histogram) {
+            classNumbers.emplace(name, static_cast<uint32_t>(classNumbers.size()));
+        }
+        std::vector<uint32_t> objectClasses(objects.size());
+        parallelFor((objects.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, workerThreads, [&](size_t block, size_t) {
+            const size_t end = std::min(objects.size(), (block + 1) * BLOCK_SIZE);
+            for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+                objectClasses[i] = classNumbers.at(getObjectClassName(static_cast<ObjectIndex>(i)));
+            }
+        });
+        const auto retainedBytes = dominators->retainedSizesByLabel(objectClasses, classNumbers.size());
+        for (auto& [name, h] : histogram) {
+            h.retainedBytes = retainedBytes[classNumbers.at(name)];
+        }
+    }
+
+    std::vector<std::pair<std::string_view, ClassHistogram>> rows(histogram.begin(), histogram.end());
+    const auto                                               key = [&](const ClassHistogram& h) {
+        return withRetainedSizes ? h.retainedBytes : h.bytes();
+    };
+    top = std::min(top, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + top, rows.end(), [&](const auto& a, const auto& b) {
+        const auto ka = key(a.second);
+        const auto kb = key(b.second);
+        return ka != kb ? ka > kb : a.first < b.first;
+    });
+    rows.resize(top);
+
+    size_t maxNameWidth = 5;
+    for (const auto& [name, h] : rows) {
+        maxNameWidth = std::max(maxNameWidth, name.size());
+    }
+
+    std::cout << std::format("\nClass histogram ({} objects, {} instance bytes, {} array bytes, "
+                             "top {} of {} classes):\n\n",
+                             all.objects,
+                             all.shallowBytes,
+                             all.arrayBytes,
+                             top,
+                             histogram.size());
+    std::cout << std::format(
+        "{:{}} | {:>11} | {:>14} | {:>14}", "class", maxNameWidth, "objects", "shallow bytes", "array bytes");
+    if (withRetainedSizes) {
+        std::cout << std::format(" | {:>14}", "retained bytes");
+    }
+    std::cout << std::format("\n{:-<{}}-+-{:-<11}-+-{:-<14}-+-{:-<14}", "", maxNameWidth, "", "", "");
+    if (withRetainedSizes) {
+        std::cout << std::format("-+-{:-<14}", "");
+    }
+    std::cout << '\n';
+    for (const auto& [name, h] : rows) {
+        std::cout << std::format(
+            "{:{}} | {:>11} | {:>14} | {:>14}", name, maxNameWidth, h.objects, h.shallowBytes, h.arrayBytes);
+        if (withRetainedSizes) {
+            std::cout << std::format(" | {:>14}", h.retainedBytes);
+        }
+        std::cout << '\n';
+    }
+}
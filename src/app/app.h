@@ -2,10 +2,24 @@
 
 #include <app/args.h>
 #include <data/data.h>
+#include <graph/dominator_tree.h>
+#include <graph/marker.h>
+#include <graph/reference_graph.h>
+#include <graph/root_paths.h>
+#include <index/class_layout.h>
+#include <index/object_directory.h>
+#include <index/sidecar.h>
 #include <parse/parse.h>
+#include <utils/fs_utils.h>
+#include <utils/gzip.h>
+#include <utils/stats.h>
 
+#include <array>
 #include <cstddef>
+#include <filesystem>
 #include <functional>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -14,16 +28,68 @@
 #include <vector>
 
 class App {
+public:
+    App() = default;
+
+    // the tables point into the arena and the mappings owned by the app
+    App(const App&)            = delete;
+    App& operator=(const App&) = delete;
+
 public:
     void run(const Args& args);
 
+    // maps and parses the dump, or loads its tables from the sidecar index, without printing anything;
+    // a dump loaded before is unloaded first
+    void load(const Args& args);
+
+    // drops all tables and unmaps the dump; the record tables are released with their arena in one go
+    void unload();
+
+    std::unordered_set<ObjectID> getCoroutineInstances();
+
+    void printCoroutinesHierarchy(const std::unordered_set<ObjectID>& coroutines);
+
 private:
+    // writes the index and reports the stats asked for, once all output is printed
+    void finish(const Args& args);
+
+    // drops the tables of the dump but keeps it mapped
+    void clearTables();
+
+    // tables of the dump from the sidecar index, instead of parsing the dump
+    void loadIndex(const Sidecar& sidecar);
+
+    // writes the sidecar index if there is none yet or graphs were computed that it lacks
+    void updateIndex(const std::filesystem::path& path, const SidecarKey& key);
+
     void printInstance(ObjectID objectID, bool recurse = false, size_t indent = 0, std::string_view name = "");
 
     void printStackFrame(StackFrameID frameID, size_t indent = 0);
 
     size_t calcRetainedHeapSize(isID auto root_);
 
+    uint64_t getShallowSize(ObjectIndex index);
+
+    // shallow sizes of all objects by index, computed on first use
+    const std::vector<uint64_t>& getShallowSizes();
+
+    std::string_view getClassName(ClassObjectID classObjectID);
+
+    // class name of instances and object arrays, element type of primitive arrays
+    std::string_view getObjectClassName(ObjectIndex index);
+
+    // graphs are built on first use, as they need a pass over all objects
+    const ReferenceGraph& getReferenceGraph();
+
+    const ReferenceGraph& getInboundReferenceGraph();
+
+    // indices of objects in ROOT_* sub-records that are present in the dump
+    std::vector<ObjectIndex> getRootIndices();
+
+    const RootPaths& getRootPaths();
+
+    const DominatorTree& getDominatorTree();
+
     void forEachSuperclass(ClassObjectID classObjectID, std::function<void(ClassObjectID)> f);
 
     void forEachField(ClassObjectID classObjectID, std::function<void(ClassDump::Field)> f);
@@ -38,16 +104,45 @@ private:
 
     bool isPrimitiveArrayID(ID id);
 
+    // reader positioned at the body of the sub-record of the given object;
+    // for a gzipped dump, its windows stay in memory for the next RECENT_PINS lookups
+    R getSubRecordReader(ID id, ObjectKind kind);
+
+    // reader of the object whose windows stay in memory as long as `pin` holds them
+    R getObjectReader(ObjectLocation location, GzipWindowCache::Pin& pin);
+
+    // of the whole dump, whose contents are only readable where fetched if it is gzipped
+    R dumpReader();
+
+    // null unless the dump is gzipped
+    GzipWindowCache* windows();
+
+    InstanceDump getInstance(ObjectID objectID);
+
+    ObjectArrayDump getObjectArray(ArrayObjectID arrayObjectID);
+
+    PrimitiveArrayDump getPrimitiveArray(ArrayObjectID arrayObjectID);
+
+    void forEachInstance(std::function<void(const InstanceDump&)> f);
+
     std::vector<ObjectID> getClassInstances(ClassObjectID classObjectID);
 
     std::unordered_set<ClassObjectID> getCoroutineClasses(bool internal = true);
 
-    std::unordered_set<ObjectID> getCoroutineInstances();
-
     void printCoroutinesList(const std::unordered_set<ObjectID>& coroutineInstances);
 
+    // layout of the class of the instance, checked to fit its fields block
+    const ClassLayout& getInstanceLayout(const InstanceDump& instance);
+
+    Value getFieldValue(const InstanceDump& instance, std::string_view fieldName);
+
     Value getFieldValue(ObjectID id, std::string_view fieldName);
 
+    // without the lookup by name once the class of the instance was seen
+    Value getFieldValue(const InstanceDump& instance, FieldHandle& field);
+
+    Value getFieldValue(ObjectID id, FieldHandle& field);
+
     std::string getCoroutineState(ObjectID id);
 
     std::string_view getView(StringID stringID);
@@ -60,18 +155,68 @@ private:
 
     std::string formatCoroutine(ObjectID id);
 
-    void printCoroutinesHierarchy(const std::unordered_set<ObjectID>& coroutines);
+    // class name and ID of any kind of object
+    std::string formatObject(ObjectIndex index);
+
+    // names of the fields, array slots or statics of `from` that reference `to`
+    std::string formatReference(ObjectIndex from, ObjectIndex to);
+
+    void printReferrers(ID id);
+
+    // kinds of all roots of the object, with their thread and frame if known
+    std::string formatGCRoots(ID id);
+
+    void printPathToRoots(ID id);
+
+    // reachable and unreachable (garbage not yet collected) objects, per class for the `top` classes
+    // with most unreachable bytes
+    void printReachability(size_t top);
+
+    // objects and their sizes per class, for the `top` classes with most bytes
+    void printHistogram(size_t top, bool withRetainedSizes);
 
 private:
-    size_t                                                 identifierSize;
-    DumpSummary                                            dumpSummary;
-    std::unordered_map<StringID, StringInUTF8>             strings;
-    std::unordered_map<ClassObjectID, LoadClass>           loadClasses;
-    std::unordered_map<ClassObjectID, ClassDump>           classDumps;
-    std::unordered_map<ClassObjectID, size_t>              classInstanceCount;
-    std::unordered_map<ObjectID, InstanceDump>             instances;
-    std::unordered_map<ArrayObjectID, ObjectArrayDump>     objectArrayDumps;
-    std::unordered_map<ArrayObjectID, PrimitiveArrayDump>  primitiveArrayDumps;
-    std::unordered_map<StackFrameID, StackFrame>           stackFrames;
-    std::unordered_map<StackTraceSerialNumber, StackTrace> stackTraces;
+    MappedFile                     dumpFile;     // compressed if gzipped
+    std::optional<Sidecar>         sidecarIndex; // tables loaded from it are used in place
+    std::optional<GzipWindowCache> dumpWindows;  // inflated contents of a gzipped dump
+    std::vector<MappedFile>        spillFiles;   // of --max-memory, viewed the same way
+    size_t                         workerThreads = 1;
+    size_t                         identifierSize;
+    DumpHeader                     dumpHeader;
+    std::filesystem::path          indexPath;
+    SidecarKey                     indexKey{};
+    DumpSummary                    dumpSummary;
+    RecordDirectory                recordDirectory;
+    // of the record tables and class layouts, declared before them so that it outlives them
+    std::pmr::monotonic_buffer_resource tableArena;
+    StringTable                         strings{&tableArena};
+    LoadClassTable                      loadClasses{&tableArena};
+    ClassDumpTable                      classDumps{&tableArena};
+    ClassLayouts                        classLayouts{&tableArena};
+    InstanceCountTable                  classInstanceCount{&tableArena};
+    ObjectDirectory                     objects;
+    GCRootTable                         gcRoots;
+    std::vector<uint64_t>               shallowSizes;
+    std::optional<ReferenceGraph>       referenceGraph;
+    std::optional<ReferenceGraph>       inboundReferenceGraph;
+    std::optional<RootPaths>            rootPaths;
+    std::optional<DominatorTree>        dominatorTree;
+    StackFrameTable                     stackFrames{&tableArena};
+    StackTraceTable                     stackTraces{&tableArena};
+    RunStats                            stats;
+
+    // windows of the last lookups of getSubRecordReader, so that views of the objects stay readable for a while
+    static constexpr size_t                       RECENT_PINS = 64;
+    std::array<GzipWindowCache::Pin, RECENT_PINS> recentPins;
+    size_t                                        nextRecentPin = 0;
+    std::mutex                                    recentPinsMutex;
+
+    // fields read for every coroutine
+    struct CoroutineFields {
+        FieldHandle state{"_state$volatile"};
+        FieldHandle isActive{"isActive"};
+        FieldHandle isCompleting{"_isCompleting$volatile"};
+        FieldHandle parentHandle{"_parentHandle$volatile"};
+        FieldHandle job{"job"};
+    } coroutineFields;
 };
@@ -2,7 +2,31 @@
 
 #include <argh.h>
 
+#include <format>
+#include <limits>
 #include <stdexcept>
+#include <string>
+
+namespace {
+
+// object IDs are given in hex, as they are printed
+std::optional<ID> parseObjectIDArg(const argh::parser& cmdl, const std::string& name) {
+    std::string value;
+    if (!(cmdl(name) >> value)) {
+        return std::nullopt;
+    }
+    try {
+        size_t     parsed = 0;
+        const auto id     = static_cast<ID>(std::stoull(value, &parsed, 16));
+        if (parsed == value.size()) {
+            return id;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error(std::format("--{} must be a hex object ID", name));
+}
+
+} // namespace
 
 Args parseArgs(int argc, char* argv[]) {
     (void)argc;
@@ -11,5 +35,37 @@ Args parseArgs(int argc, char* argv[]) {
     if (!(cmdl("dump-file") >> args.dumpFile)) {
         throw std::runtime_error("--dump-file is required");
     }
+    if (!(cmdl("threads", 1) >> args.threads) || args.threads == 0) {
+        throw std::runtime_error("--threads must be a positive number");
+    }
+    args.useIndex      = !cmdl["no-index"];
+    args.unreachable   = cmdl["unreachable"];
+    args.histogram     = cmdl["histogram"];
+    args.retainedSizes = cmdl["retained"];
+    if (args.retainedSizes && !args.histogram) {
+        throw std::runtime_error("--retained only applies to --histogram");
+    }
+    if (!(cmdl("top", args.histogramTop) >> args.histogramTop) || args.histogramTop == 0) {
+        throw std::runtime_error("--top must be a positive number");
+    }
+    args.referrersOf   = parseObjectIDArg(cmdl, "referrers");
+    args.pathToRootsOf = parseObjectIDArg(cmdl, "path-to-roots");
+    args.stats         = cmdl["stats"];
+    if (std::filesystem::path path; cmdl("stats-json") >> path) {
+        args.statsJSONFile = std::move(path);
+    }
+    if (std::string value; cmdl("max-memory") >> value) {
+        size_t megabytes = 0;
+        if (!(cmdl("max-memory") >> megabytes) || megabytes == 0 ||
+            megabytes > std::numeric_limits<size_t>::max() >> 20) {
+            throw std::runtime_error("--max-memory must be a positive number of MiB");
+        }
+        args.maxMemoryBytes = megabytes << 20;
+        // these need the reference graph, which is as large as the heap
+        if (args.retainedSizes || args.unreachable || args.referrersOf.has_value() ||
+            args.pathToRootsOf.has_value()) {
+            throw std::runtime_error("--max-memory only supports --histogram without --retained and the coroutines");
+        }
+    }
     return args;
 }
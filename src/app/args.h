@@ -1,9 +1,30 @@
 #pragma once
 
+#include <data/data.h>
+
+#include <cstddef>
 #include <filesystem>
+#include <optional>
 
 struct Args {
     std::filesystem::path dumpFile;
+    size_t                threads  = 1;
+    bool                  useIndex = true; // read and write the sidecar index next to the dump
+
+    // bounded-memory mode for dumps larger than RAM, object tables are spilled to disk next to the dump
+    std::optional<size_t> maxMemoryBytes;
+
+    // timing, memory and table sizes of the run, printed at the end and/or written as JSON
+    bool                                 stats = false;
+    std::optional<std::filesystem::path> statsJSONFile;
+
+    // reports and queries about single objects, printed instead of the coroutines
+    bool              unreachable   = false;
+    bool              histogram     = false;
+    size_t            histogramTop  = 25;    // classes listed in the histogram and the reachability report
+    bool              retainedSizes = false; // in the histogram, needs the dominator tree
+    std::optional<ID> referrersOf;
+    std::optional<ID> pathToRootsOf;
 };
 
 Args parseArgs(int argc, char* argv[]);
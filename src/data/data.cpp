@@ -106,6 +106,26 @@ size_t subTagSize(SubTag subTag, size_t identifierSize) {
     throw std::runtime_error("unreachable code");
 }
 
+size_t subTagIndex(SubTag subTag) {
+    switch (subTag) {
+        using enum SubTag;
+    case ROOT_UNKNOWN:         return 0;
+    case ROOT_JNI_GLOBAL:      return 1;
+    case ROOT_JNI_LOCAL:       return 2;
+    case ROOT_JAVA_FRAME:      return 3;
+    case ROOT_NATIVE_STACK:    return 4;
+    case ROOT_STICKY_CLASS:    return 5;
+    case ROOT_THREAD_BLOCK:    return 6;
+    case ROOT_MONITOR_USED:    return 7;
+    case ROOT_THREAD_OBJECT:   return 8;
+    case CLASS_DUMP:           return 9;
+    case INSTANCE_DUMP:        return 10;
+    case OBJECT_ARRAY_DUMP:    return 11;
+    case PRIMITIVE_ARRAY_DUMP: return 12;
+    }
+    throw std::runtime_error("unreachable code");
+}
+
 BasicType validateBasicType(uint8_t maybeBasicType) {
     BasicType result = static_cast<BasicType>(maybeBasicType);
     switch (result) {
@@ -139,10 +159,26 @@ const char* basicTypeName(BasicType basicType) {
     throw std::runtime_error("unreachable code");
 }
 
-size_t basicTypeSize(BasicType basicType) {
+const char* basicTypeArrayName(BasicType basicType) {
+    switch (basicType) {
+        using enum BasicType;
+    case OBJECT:  return "object[]";
+    case BOOLEAN: return "boolean[]";
+    case CHAR:    return "char[]";
+    case FLOAT:   return "float[]";
+    case DOUBLE:  return "double[]";
+    case BYTE:    return "byte[]";
+    case SHORT:   return "short[]";
+    case INT:     return "int[]";
+    case LONG:    return "long[]";
+    }
+    throw std::runtime_error("unreachable code");
+}
+
+size_t basicTypeSize(BasicType basicType, size_t identifierSize) {
     switch (basicType) {
         using enum BasicType;
-    case OBJECT:  return 8;
+    case OBJECT:  return identifierSize;
     case BOOLEAN: return 1; // assume 1
     case CHAR:    return 2;
     case FLOAT:   return 4;
@@ -4,8 +4,10 @@
 #include <cstdint>
 #include <format>
 #include <limits>
+#include <memory_resource>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 using ID    = uint64_t;
@@ -52,9 +54,12 @@ enum class SubTag : uint8_t {
 
 static constexpr size_t DYNAMIC = std::numeric_limits<size_t>::max();
 
+static constexpr size_t NUM_SUB_TAGS = 13;
+
 SubTag      validateSubTag(uint8_t maybeSubTag);
 const char* subTagName(SubTag subTag);
 size_t      subTagSize(SubTag subTag, size_t identifierSize);
+size_t      subTagIndex(SubTag subTag); // dense index in [0, NUM_SUB_TAGS)
 
 enum class BasicType : uint8_t {
     OBJECT  = 0x02,
@@ -70,7 +75,8 @@ enum class BasicType : uint8_t {
 
 BasicType   validateBasicType(uint8_t maybeBasicType);
 const char* basicTypeName(BasicType basicType);
-size_t      basicTypeSize(BasicType basicType);
+const char* basicTypeArrayName(BasicType basicType);
+size_t      basicTypeSize(BasicType basicType, size_t identifierSize); // OBJECT values are identifiers
 
 struct DumpHeader {
     uint32_t identifierSize;
@@ -99,7 +105,9 @@ struct LoadClass {
     StringID      nameStringID;
 };
 
+// the per-class arrays are allocated from the memory resource of the table the class dump is in
 struct ClassDump {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
 
     struct Constant {
         uint16_t  constantPoolIndex;
@@ -116,17 +124,40 @@ struct ClassDump {
         BasicType type;
     };
 
-    ClassObjectID         classObjectID;
-    uint32_t              stackTrackeSerialNumber;
-    ClassObjectID         superclassObjectID;
-    ID                    classLoaderObjectID;
-    ID                    signersObjectID;
-    ID                    protectionDomainObjectID;
-    ID                    reserved[2];
-    uint32_t              instanceSizeBytes;
-    std::vector<Constant> constants;
-    std::vector<Static>   statics;
-    std::vector<Field>    fields;
+    ClassDump() = default;
+
+    explicit ClassDump(const allocator_type& allocator)
+      : constants(allocator)
+      , statics(allocator)
+      , fields(allocator) {}
+
+    // pmr containers keep their own allocator on assignment, so the arrays are copied or moved into `allocator`
+    ClassDump(const ClassDump& other, const allocator_type& allocator)
+      : ClassDump(allocator) {
+        *this = other;
+    }
+
+    ClassDump(ClassDump&& other, const allocator_type& allocator)
+      : ClassDump(allocator) {
+        *this = std::move(other);
+    }
+
+    ClassDump(const ClassDump&)            = default;
+    ClassDump(ClassDump&&)                 = default;
+    ClassDump& operator=(const ClassDump&) = default;
+    ClassDump& operator=(ClassDump&&)      = default;
+
+    ClassObjectID              classObjectID;
+    uint32_t                   stackTrackeSerialNumber;
+    ClassObjectID              superclassObjectID;
+    ID                         classLoaderObjectID;
+    ID                         signersObjectID;
+    ID                         protectionDomainObjectID;
+    ID                         reserved[2];
+    uint32_t                   instanceSizeBytes;
+    std::pmr::vector<Constant> constants;
+    std::pmr::vector<Static>   statics;
+    std::pmr::vector<Field>    fields;
 };
 
 enum class ObjectID : ID {};
@@ -151,11 +182,34 @@ struct StackFrame {
 
 enum class StackTraceSerialNumber : uint32_t {};
 
+// the frames are allocated from the memory resource of the table the stack trace is in
 struct StackTrace {
-    StackTraceSerialNumber    stackTraceSerialNumber;
-    uint32_t                  threadSerialNumber;
-    uint32_t                  numberOfFrames;
-    std::vector<StackFrameID> stackFrames;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    StackTrace() = default;
+
+    explicit StackTrace(const allocator_type& allocator)
+      : stackFrames(allocator) {}
+
+    StackTrace(const StackTrace& other, const allocator_type& allocator)
+      : StackTrace(allocator) {
+        *this = other;
+    }
+
+    StackTrace(StackTrace&& other, const allocator_type& allocator)
+      : StackTrace(allocator) {
+        *this = std::move(other);
+    }
+
+    StackTrace(const StackTrace&)            = default;
+    StackTrace(StackTrace&&)                 = default;
+    StackTrace& operator=(const StackTrace&) = default;
+    StackTrace& operator=(StackTrace&&)      = default;
+
+    StackTraceSerialNumber         stackTraceSerialNumber;
+    uint32_t                       threadSerialNumber;
+    uint32_t                       numberOfFrames;
+    std::pmr::vector<StackFrameID> stackFrames;
 };
 
 enum class ArrayObjectID : ID {};
@@ -185,6 +239,15 @@ struct RootThread {
     StackTraceSerialNumber stackTraceSerialNumber;
 };
 
+// tables of the records of a dump; their nodes, and the arrays of their class dumps and stack traces,
+// come from one memory resource, so that an arena can release them all at once
+using StringTable        = std::pmr::unordered_map<StringID, StringInUTF8>;
+using LoadClassTable     = std::pmr::unordered_map<ClassObjectID, LoadClass>;
+using ClassDumpTable     = std::pmr::unordered_map<ClassObjectID, ClassDump>;
+using InstanceCountTable = std::pmr::unordered_map<ClassObjectID, size_t>;
+using StackFrameTable    = std::pmr::unordered_map<StackFrameID, StackFrame>;
+using StackTraceTable    = std::pmr::unordered_map<StackTraceSerialNumber, StackTrace>;
+
 inline bool isNull(isID auto id) {
     return static_cast<ID>(id) == 0;
 }
@@ -0,0 +1,223 @@
+#include <graph/dominator_tree.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+DominatorTree::DominatorTree(std::span<const uint64_t>    offsets,
+                             std::span<const ObjectIndex> targets,
+                             std::span<const ObjectIndex> roots,
+                             std::span<const uint64_t>    shallowSizes) {
+    const size_t n = shallowSizes.size();
+    if (offsets.size() != n + 1) {
+        throw std::runtime_error("reference graph does not match the number of objects");
+    }
+
+    // the super-root gets index n, all other arrays below are indexed by DFS preorder number
+    const ObjectIndex superRoot = static_cast<ObjectIndex>(n);
+    const auto        edges     = [&](ObjectIndex v) {
+        return v == superRoot ? roots : targets.subspan(offsets[v], offsets[v + 1] - offsets[v]);
+    };
+
+    std::vector<ObjectIndex> preorder(n + 1, NO_OBJECT);
+    std::vector<ObjectIndex> vertex;
+    std::vector<ObjectIndex> parent;
+    {
+        std::vector<std::pair<ObjectIndex, size_t>> stack;
+        preorder[superRoot] = 0;
+        vertex.push_back(superRoot);
+        parent.push_back(NO_OBJECT);
+        stack.emplace_back(superRoot, 0);
+        while (!stack.empty()) {
+            auto& [v, next] = stack.back();
+            const auto e    = edges(v);
+            if (next == e.size()) {
+                stack.pop_back();
+                continue;
+            }
+            const ObjectIndex w = e[next++];
+            if (preorder[w] == NO_OBJECT) {
+                preorder[w] = static_cast<ObjectIndex>(vertex.size());
+                parent.push_back(preorder[v]);
+                vertex.push_back(w);
+                stack.emplace_back(w, 0);
+            }
+        }
+    }
+    const size_t m = vertex.size();
+
+    // predecessors of reached vertices, in preorder numbers
+    std::vector<uint64_t>    predOffsets(m + 1, 0);
+    std::vector<ObjectIndex> preds;
+    {
+        for (size_t d = 0; d < m; ++d) {
+            for (const auto w : edges(vertex[d])) {
+                ++predOffsets[preorder[w] + 1];
+            }
+        }
+        for (size_t d = 0; d < m; ++d) {
+            predOffsets[d + 1] += predOffsets[d];
+        }
+        preds.resize(predOffsets[m]);
+        std::vector<uint64_t> fill(predOffsets.begin(), predOffsets.end() - 1);
+        for (size_t d = 0; d < m; ++d) {
+            for (const auto w : edges(vertex[d])) {
+                preds[fill[preorder[w]]++] = static_cast<ObjectIndex>(d);
+            }
+        }
+    }
+
+    std::vector<ObjectIndex> semi(m);
+    std::vector<ObjectIndex> label(m);
+    std::vector<ObjectIndex> ancestor(m, NO_OBJECT);
+    std::vector<ObjectIndex> idom(m, 0);
+    std::vector<ObjectIndex> bucketHead(m, NO_OBJECT);
+    std::vector<ObjectIndex> bucketNext(m, NO_OBJECT);
+    for (size_t d = 0; d < m; ++d) {
+        semi[d]  = static_cast<ObjectIndex>(d);
+        label[d] = static_cast<ObjectIndex>(d);
+    }
+
+    std::vector<ObjectIndex> path;
+    const auto               eval = [&](ObjectIndex v) {
+        if (ancestor[v] == NO_OBJECT) {
+            return v;
+        }
+        // iterative path compression
+        for (ObjectIndex x = v; ancestor[ancestor[x]] != NO_OBJECT; x = ancestor[x]) {
+            path.push_back(x);
+        }
+        while (!path.empty()) {
+            const ObjectIndex y = path.back();
+            const ObjectIndex a = ancestor[y];
+            path.pop_back();
+            if (semi[label[a]] < semi[label[y]]) {
+                label[y] = label[a];
+            }
+            ancestor[y] = ancestor[a];
+        }
+        return label[v];
+    };
+
+    for (size_t d = m - 1; d >= 1; --d) {
+        const auto w = static_cast<ObjectIndex>(d);
+        for (uint64_t i = predOffsets[w]; i < predOffsets[w + 1]; ++i) {
+            semi[w] = std::min(semi[w], semi[eval(preds[i])]);
+        }
+        bucketNext[w]          = bucketHead[semi[w]];
+        bucketHead[semi[w]]    = w;
+        const ObjectIndex p    = parent[w];
+        ancestor[w]            = p;
+        for (ObjectIndex v = bucketHead[p]; v != NO_OBJECT; v = bucketNext[v]) {
+            const ObjectIndex u = eval(v);
+            idom[v]             = semi[u] < semi[v] ? u : p;
+        }
+        bucketHead[p] = NO_OBJECT;
+    }
+    for (size_t d = 1; d < m; ++d) {
+        if (idom[d] != semi[d]) {
+            idom[d] = idom[idom[d]];
+        }
+    }
+
+    // dominators precede the vertices they dominate in preorder
+    std::vector<uint64_t> retained(m, 0);
+    for (size_t d = 1; d < m; ++d) {
+        retained[d] = shallowSizes[vertex[d]];
+    }
+    for (size_t d = m - 1; d >= 1; --d) {
+        retained[idom[d]] += retained[d];
+    }
+
+    std::vector<ObjectIndex> immediateDominators(n, NO_OBJECT);
+    std::vector<uint8_t>     reachable(n, 0);
+    std::vector<uint64_t>    retainedSizes(n, 0);
+    for (size_t d = 1; d < m; ++d) {
+        const ObjectIndex v    = vertex[d];
+        immediateDominators[v] = idom[d] == 0 ? NO_OBJECT : vertex[idom[d]];
+        reachable[v]           = 1;
+        retainedSizes[v]       = retained[d];
+    }
+    immediateDominators_ = std::move(immediateDominators);
+    reachable_           = std::move(reachable);
+    retainedSizes_       = std::move(retainedSizes);
+}
+
+std::vector<uint64_t> DominatorTree::retainedSizesByLabel(std::span<const uint32_t> labels, size_t numLabels) const {
+    const size_t n = size();
+    if (labels.size() != n) {
+        throw std::runtime_error("labels do not match the number of objects");
+    }
+
+    // children of each object in compressed sparse row form, with the objects dominated by the super-root under n
+    const ObjectIndex     superRoot = static_cast<ObjectIndex>(n);
+    std::vector<uint64_t> offsets(n + 2, 0);
+    for (size_t v = 0; v < n; ++v) {
+        if (isReachable(static_cast<ObjectIndex>(v))) {
+            const ObjectIndex d = immediateDominators_[v];
+            ++offsets[(d == NO_OBJECT ? superRoot : d) + 1];
+        }
+    }
+    for (size_t v = 0; v <= n; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<ObjectIndex> children(offsets[n + 1]);
+    {
+        std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t v = 0; v < n; ++v) {
+            if (isReachable(static_cast<ObjectIndex>(v))) {
+                const ObjectIndex d                              = immediateDominators_[v];
+                children[fill[d == NO_OBJECT ? superRoot : d]++] = static_cast<ObjectIndex>(v);
+            }
+        }
+    }
+
+    // top-down walk that counts how many objects of each label are on the path from the super-root
+    std::vector<uint64_t>                         sizes(numLabels, 0);
+    std::vector<uint32_t>                         onPath(numLabels, 0);
+    std::vector<std::pair<ObjectIndex, uint64_t>> stack;
+    stack.emplace_back(superRoot, offsets[superRoot]);
+    while (!stack.empty()) {
+        auto& [v, next] = stack.back();
+        if (next == offsets[v + 1]) {
+            if (v != superRoot) {
+                --onPath[labels[v]];
+            }
+            stack.pop_back();
+            continue;
+        }
+        const ObjectIndex w = children[next++];
+        if (onPath[labels[w]]++ == 0) {
+            sizes[labels[w]] += retainedSize(w);
+        }
+        stack.emplace_back(w, offsets[w]);
+    }
+    return sizes;
+}
+
+void DominatorTree::save(SidecarWriter& writer) const {
+    writer.add(SidecarSection::IMMEDIATE_DOMINATORS, immediateDominators_.span());
+    writer.add(SidecarSection::DOMINATOR_REACHABLE, reachable_.span());
+    writer.add(SidecarSection::RETAINED_SIZES, retainedSizes_.span());
+}
+
+std::optional<DominatorTree> DominatorTree::load(const Sidecar& sidecar) {
+    if (!sidecar.contains(SidecarSection::IMMEDIATE_DOMINATORS)) {
+        return std::nullopt;
+    }
+    DominatorTree tree;
+    tree.immediateDominators_ =
+        Column<ObjectIndex>::view(sidecar.section<ObjectIndex>(SidecarSection::IMMEDIATE_DOMINATORS));
+    tree.reachable_     = Column<uint8_t>::view(sidecar.section<uint8_t>(SidecarSection::DOMINATOR_REACHABLE));
+    tree.retainedSizes_ = Column<uint64_t>::view(sidecar.section<uint64_t>(SidecarSection::RETAINED_SIZES));
+    if (tree.reachable_.size() != tree.size() || tree.retainedSizes_.size() != tree.size()) {
+        throw std::runtime_error("corrupt dominator tree in index");
+    }
+    // the index has no checksum, so dominators are checked once here before they are used as indices
+    for (const auto dominator : tree.immediateDominators_) {
+        if (dominator != NO_OBJECT && dominator >= tree.size()) {
+            throw std::runtime_error("corrupt dominator tree in index");
+        }
+    }
+    return tree;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <index/object_directory.h>
+#include <index/sidecar.h>
+#include <utils/column.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+// dominator tree of the object graph, computed with the Lengauer-Tarjan algorithm
+// (simple version with path compression) from a virtual super-root that points at all GC roots;
+// the graph is given in compressed sparse row form over dense object indices:
+// outgoing references of object i are targets[offsets[i], offsets[i + 1])
+class DominatorTree {
+
+public:
+    DominatorTree() = default;
+
+    // shallowSizes has one entry per object, offsets one more
+    DominatorTree(std::span<const uint64_t>    offsets,
+                  std::span<const ObjectIndex> targets,
+                  std::span<const ObjectIndex> roots,
+                  std::span<const uint64_t>    shallowSizes);
+
+    void save(SidecarWriter& writer) const;
+
+    // nullopt if the tree was not saved to the index
+    static std::optional<DominatorTree> load(const Sidecar& sidecar);
+
+public:
+    // NO_OBJECT if the object is unreachable or only dominated by the super-root,
+    // e.g. because it is a GC root itself or is reachable from several of them
+    ObjectIndex immediateDominator(ObjectIndex index) const {
+        return immediateDominators_[index];
+    }
+
+    bool isReachable(ObjectIndex index) const {
+        return reachable_[index] != 0;
+    }
+
+    // total shallow size of the objects that would be collected together with this one, 0 if unreachable
+    uint64_t retainedSize(ObjectIndex index) const {
+        return retainedSizes_[index];
+    }
+
+    size_t size() const {
+        return immediateDominators_.size();
+    }
+
+    // retained size of each label in [0, numLabels) given one label per object, e.g. its class:
+    // an object dominated by another one of its label is already retained by that one and not counted again
+    std::vector<uint64_t> retainedSizesByLabel(std::span<const uint32_t> labels, size_t numLabels) const;
+
+    size_t memoryBytes() const {
+        return immediateDominators_.memoryBytes() + reachable_.memoryBytes() + retainedSizes_.memoryBytes();
+    }
+
+private:
+    Column<ObjectIndex> immediateDominators_;
+    Column<uint8_t>     reachable_; // bytes rather than bits, so that it can be used in place of the index
+    Column<uint64_t>    retainedSizes_;
+};
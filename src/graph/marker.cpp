@@ -0,0 +1,130 @@
+#include <graph/marker.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// objects a thread keeps to itself before sharing the rest through its deque
+constexpr size_t LOCAL_STACK_LIMIT = 256;
+
+struct WorkQueue {
+    std::mutex              mutex;
+    std::deque<ObjectIndex> objects;
+};
+
+class Marker {
+
+public:
+    Marker(const ReferenceGraph& graph, size_t threads)
+      : graph_(graph)
+      , marks_(graph.numObjects())
+      , queues_(threads)
+      , active_(threads) {}
+
+    AtomicBitmap run(std::span<const ObjectIndex> roots) {
+        for (size_t i = 0; i < roots.size(); ++i) {
+            if (marks_.testAndSet(roots[i])) {
+                queues_[i % queues_.size()].objects.push_back(roots[i]);
+            }
+        }
+
+        std::vector<std::thread> pool;
+        pool.reserve(queues_.size() - 1);
+        for (size_t thread = 1; thread < queues_.size(); ++thread) {
+            pool.emplace_back([this, thread] { work(thread); });
+        }
+        work(0);
+        for (auto& t : pool) {
+            t.join();
+        }
+        return std::move(marks_);
+    }
+
+private:
+    void work(size_t thread) {
+        std::vector<ObjectIndex> stack;
+        while (true) {
+            while (!stack.empty() || popOwn(thread, stack) || steal(thread, stack)) {
+                const ObjectIndex v = stack.back();
+                stack.pop_back();
+                for (const auto w : graph_.references(v)) {
+                    if (marks_.testAndSet(w)) {
+                        stack.push_back(w);
+                    }
+                }
+                if (stack.size() > LOCAL_STACK_LIMIT) {
+                    share(thread, stack);
+                }
+            }
+
+            // nothing left anywhere this thread can see; work only appears while some thread is active,
+            // so once none is, every deque is empty and marking is done
+            active_.fetch_sub(1);
+            while (true) {
+                if (steal(thread, stack)) {
+                    active_.fetch_add(1);
+                    break;
+                }
+                if (active_.load() == 0) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // moves the older half of the local stack to the deque of the thread
+    void share(size_t thread, std::vector<ObjectIndex>& stack) {
+        const size_t half = stack.size() / 2;
+        auto&        q    = queues_[thread];
+        {
+            std::lock_guard lock(q.mutex);
+            q.objects.insert(q.objects.end(), stack.begin(), stack.begin() + half);
+        }
+        stack.erase(stack.begin(), stack.begin() + half);
+    }
+
+    bool popOwn(size_t thread, std::vector<ObjectIndex>& stack) {
+        auto&           q = queues_[thread];
+        std::lock_guard lock(q.mutex);
+        if (q.objects.empty()) {
+            return false;
+        }
+        stack.push_back(q.objects.back());
+        q.objects.pop_back();
+        return true;
+    }
+
+    // takes half of the deque of the first other thread that has any work
+    bool steal(size_t thread, std::vector<ObjectIndex>& stack) {
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            auto&           q = queues_[(thread + k) % queues_.size()];
+            std::lock_guard lock(q.mutex);
+            if (q.objects.empty()) {
+                continue;
+            }
+            const size_t n = std::max<size_t>(1, q.objects.size() / 2);
+            stack.insert(stack.end(), q.objects.begin(), q.objects.begin() + n);
+            q.objects.erase(q.objects.begin(), q.objects.begin() + n);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const ReferenceGraph&  graph_;
+    AtomicBitmap           marks_;
+    std::vector<WorkQueue> queues_;
+    std::atomic<size_t>    active_;
+};
+
+} // namespace
+
+AtomicBitmap markReachable(const ReferenceGraph& graph, std::span<const ObjectIndex> roots, size_t threads) {
+    return Marker(graph, std::max<size_t>(1, threads)).run(roots);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <graph/reference_graph.h>
+#include <index/object_directory.h>
+#include <utils/atomic_bitmap.h>
+
+#include <cstddef>
+#include <span>
+
+// marks every object reachable from the roots, on up to `threads` threads;
+// each thread works off its own deque and steals from the others when it runs dry
+AtomicBitmap markReachable(const ReferenceGraph& graph, std::span<const ObjectIndex> roots, size_t threads = 1);
@@ -0,0 +1,226 @@
+#include <graph/reference_graph.h>
+
+#include <parse/parse.h>
+#include <utils/parallel.h>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// objects are handed out to threads in blocks of this many
+constexpr size_t BLOCK_SIZE = size_t{1} << 16;
+
+// IDSize is size_t or IdentifierSize<N>, see withIdentifierSize
+template <typename IDSize>
+struct ReferenceDecoder {
+    R                      dump;
+    IDSize                 identifierSize;
+    const ObjectDirectory& objects;
+    const ClassLayouts&    classLayouts;
+    const ClassDumpTable&  classDumps;
+    GzipWindowCache*       windows;
+
+    // f(ObjectIndex) for every resolvable reference of the object
+    template <typename F>
+    void forEachReference(ObjectIndex index, F&& f) const {
+        const auto add = [&](ID id) {
+            if (const auto target = objects.indexOf(id); target != NO_OBJECT) {
+                f(target);
+            }
+        };
+
+        const auto           location = objects.location(index);
+        GzipWindowCache::Pin pin;
+        switch (location.kind) {
+            using enum ObjectKind;
+        case INSTANCE: {
+            R           r        = objectDumpReader(dump, location, identifierSize, windows, pin);
+            const auto  instance = parseInstanceDump(r, identifierSize);
+            const auto& layout   = classLayouts.at(instance.classObjectID);
+            if (instance.fieldsView.size_bytes() < layout.fieldsByteSize) {
+                throw std::runtime_error(
+                    std::format("instance {} is too small for its class", formatID(instance.objectID)));
+            }
+            for (const auto& field : layout.fields) {
+                if (field.ref.type == BasicType::OBJECT) {
+                    add(readField(instance.fieldsView, field.ref));
+                }
+            }
+            break;
+        }
+        case OBJECT_ARRAY: {
+            R          r     = objectDumpReader(dump, location, identifierSize, windows, pin);
+            const auto array = parseObjectArrayDump(r, identifierSize);
+            forEachBigEndianID(array.elementsView, identifierSize, add);
+            break;
+        }
+        case CLASS: {
+            for (const auto& s : classDumps.at(static_cast<ClassObjectID>(objects.id(index))).statics) {
+                if (s.type == BasicType::OBJECT) {
+                    add(static_cast<ID>(s.value));
+                }
+            }
+            break;
+        }
+        case PRIMITIVE_ARRAY:
+        case NONE:            break;
+        }
+    }
+};
+
+template <typename IDSize>
+ReferenceGraph buildReferenceGraph(const ReferenceDecoder<IDSize>& decoder, size_t threads) {
+    const size_t n         = decoder.objects.size();
+    const size_t numBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    // references are decoded twice: once to count them, once to fill them in place
+    std::vector<uint64_t> offsets(n + 1, 0);
+    parallelFor(numBlocks, threads, [&](size_t block, size_t) {
+        const size_t end = std::min(n, (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+            uint64_t count = 0;
+            decoder.forEachReference(static_cast<ObjectIndex>(i), [&](ObjectIndex) { ++count; });
+            offsets[i + 1] = count;
+        }
+    });
+    for (size_t i = 0; i < n; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<ObjectIndex> targets(offsets[n]);
+    parallelFor(numBlocks, threads, [&](size_t block, size_t) {
+        const size_t end = std::min(n, (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; ++i) {
+            uint64_t next = offsets[i];
+            decoder.forEachReference(static_cast<ObjectIndex>(i),
+                                     [&](ObjectIndex target) { targets[next++] = target; });
+        }
+    });
+
+    return ReferenceGraph(std::move(offsets), std::move(targets));
+}
+
+} // namespace
+
+std::optional<ReferenceGraph> ReferenceGraph::load(const Sidecar& sidecar) {
+    if (!sidecar.contains(SidecarSection::REFERENCE_OFFSETS)) {
+        return std::nullopt;
+    }
+    ReferenceGraph graph;
+    graph.offsets_ = Column<uint64_t>::view(sidecar.section<uint64_t>(SidecarSection::REFERENCE_OFFSETS));
+    graph.targets_ = Column<ObjectIndex>::view(sidecar.section<ObjectIndex>(SidecarSection::REFERENCE_TARGETS));
+    if (graph.offsets_.empty() || graph.offsets_[0] != 0 ||
+        graph.offsets_[graph.offsets_.size() - 1] != graph.targets_.size()) {
+        throw std::runtime_error("corrupt reference graph in index");
+    }
+    // the index has no checksum, so offsets and targets are checked once here before they are used as indices
+    for (size_t i = 1; i < graph.offsets_.size(); ++i) {
+        if (graph.offsets_[i] < graph.offsets_[i - 1]) {
+            throw std::runtime_error("corrupt reference graph in index");
+        }
+    }
+    const size_t numObjects = graph.numObjects();
+    for (const auto target : graph.targets_) {
+        if (target >= numObjects) {
+            throw std::runtime_error("corrupt reference graph in index");
+        }
+    }
+    return graph;
+}
+
+ReferenceGraph buildReferenceGraph(R                      dump,
+                                   size_t                 identifierSize,
+                                   const ObjectDirectory& objects,
+                                   const ClassLayouts&    classLayouts,
+                                   const ClassDumpTable&  classDumps,
+                                   size_t                 threads,
+                                   GzipWindowCache*       windows) {
+    return withIdentifierSize(identifierSize, [&](auto idSize) {
+        const ReferenceDecoder<decltype(idSize)> decoder{dump, idSize, objects, classLayouts, classDumps, windows};
+        return buildReferenceGraph(decoder, threads);
+    });
+}
+
+ReferenceGraph transposeReferenceGraph(const ReferenceGraph& graph, size_t threads) {
+    const size_t n = graph.numObjects();
+    if (n == 0) {
+        return ReferenceGraph({0}, {});
+    }
+    const size_t numEdges  = graph.numReferences();
+    const size_t numBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const auto   offsets   = graph.offsets();
+    const auto   targets   = graph.targets();
+
+    // references are bucketed by block of their target in two passes over contiguous parts of the sources,
+    // each counting into and then scattering from its own histogram of blocks, so no thread shares a counter;
+    // parts are cut at about equal numbers of references and scattered in order, so buckets keep source order
+    const size_t        numParts = std::max<size_t>(1, std::min(numBlocks, 4 * std::max<size_t>(1, threads)));
+    std::vector<size_t> partBegins(numParts + 1, n);
+    partBegins[0] = 0;
+    for (size_t part = 1; part < numParts; ++part) {
+        const auto edge  = numEdges / numParts * part;
+        partBegins[part] = std::upper_bound(offsets.begin(), offsets.end() - 1, edge) - offsets.begin() - 1;
+    }
+
+    // histograms[part * numBlocks + block], turned into the next free position of the part in each bucket
+    std::vector<uint64_t> histograms(numParts * numBlocks, 0);
+    parallelFor(numParts, threads, [&](size_t part, size_t) {
+        uint64_t* histogram = histograms.data() + part * numBlocks;
+        for (const auto target : targets.subspan(offsets[partBegins[part]],
+                                                 offsets[partBegins[part + 1]] - offsets[partBegins[part]])) {
+            ++histogram[target / BLOCK_SIZE];
+        }
+    });
+    std::vector<uint64_t> bucketBegins(numBlocks + 1, 0);
+    for (size_t block = 0, position = 0; block < numBlocks; ++block) {
+        bucketBegins[block] = position;
+        for (size_t part = 0; part < numParts; ++part) {
+            position += std::exchange(histograms[part * numBlocks + block], position);
+        }
+    }
+    bucketBegins[numBlocks] = numEdges;
+
+    // referrers are scattered into their buckets first, along with the target each one refers to
+    std::vector<ObjectIndex> referrers(numEdges);
+    std::vector<ObjectIndex> bucketTargets(numEdges);
+    parallelFor(numParts, threads, [&](size_t part, size_t) {
+        uint64_t* next = histograms.data() + part * numBlocks;
+        for (size_t i = partBegins[part]; i < partBegins[part + 1]; ++i) {
+            for (const auto target : graph.references(static_cast<ObjectIndex>(i))) {
+                const auto position     = next[target / BLOCK_SIZE]++;
+                referrers[position]     = static_cast<ObjectIndex>(i);
+                bucketTargets[position] = target;
+            }
+        }
+    });
+    histograms = {};
+
+    // then each bucket is sorted by target with a counting sort that keeps source order within rows
+    std::vector<uint64_t> transposedOffsets(n + 1);
+    transposedOffsets[n] = numEdges;
+    parallelFor(numBlocks, threads, [&](size_t block, size_t) {
+        const size_t begin       = block * BLOCK_SIZE;
+        const size_t end         = std::min(n, begin + BLOCK_SIZE);
+        const auto   bucketBegin = bucketBegins[block];
+        const auto   bucketEnd   = bucketBegins[block + 1];
+
+        std::vector<uint64_t> next(end - begin, 0);
+        for (auto position = bucketBegin; position < bucketEnd; ++position) {
+            ++next[bucketTargets[position] - begin];
+        }
+        for (size_t i = begin, position = bucketBegin; i < end; ++i) {
+            transposedOffsets[i] = position;
+            position += std::exchange(next[i - begin], position);
+        }
+
+        const std::vector<ObjectIndex> bucket(referrers.begin() + bucketBegin, referrers.begin() + bucketEnd);
+        for (auto position = bucketBegin; position < bucketEnd; ++position) {
+            referrers[next[bucketTargets[position] - begin]++] = bucket[position - bucketBegin];
+        }
+    });
+
+    return ReferenceGraph(std::move(transposedOffsets), std::move(referrers));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <data/data.h>
+#include <index/class_layout.h>
+#include <index/object_directory.h>
+#include <index/sidecar.h>
+#include <utils/column.h>
+#include <utils/gzip.h>
+#include <utils/reader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// references of every object in compressed sparse row form:
+// references of object i are targets[offsets[i], offsets[i + 1]);
+// outgoing references are in the order of the fields (as in ClassLayout) or array elements they come from,
+// in a transposed graph these are the referrers of object i, sorted by index
+class ReferenceGraph {
+
+public:
+    ReferenceGraph() = default;
+
+    ReferenceGraph(std::vector<uint64_t> offsets, std::vector<ObjectIndex> targets)
+      : offsets_(std::move(offsets))
+      , targets_(std::move(targets)) {}
+
+    void save(SidecarWriter& writer) const {
+        writer.add(SidecarSection::REFERENCE_OFFSETS, offsets_.span());
+        writer.add(SidecarSection::REFERENCE_TARGETS, targets_.span());
+    }
+
+    // nullopt if the graph was not saved to the index
+    static std::optional<ReferenceGraph> load(const Sidecar& sidecar);
+
+public:
+    std::span<const ObjectIndex> references(ObjectIndex index) const {
+        return targets_.span().subspan(offsets_[index], offsets_[index + 1] - offsets_[index]);
+    }
+
+    std::span<const uint64_t> offsets() const {
+        return offsets_;
+    }
+
+    std::span<const ObjectIndex> targets() const {
+        return targets_;
+    }
+
+    size_t numObjects() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    size_t numReferences() const {
+        return targets_.size();
+    }
+
+    size_t memoryBytes() const {
+        return offsets_.memoryBytes() + targets_.memoryBytes();
+    }
+
+private:
+    Column<uint64_t>    offsets_;
+    Column<ObjectIndex> targets_;
+};
+
+// references from instance fields, object array elements and class statics, decoded on up to `threads` threads;
+// null references and references to objects missing from the dump are dropped;
+// with `windows`, dump reads the inflated contents of a gzipped dump, which are fetched object by object
+ReferenceGraph buildReferenceGraph(R                      dump,
+                                   size_t                 identifierSize,
+                                   const ObjectDirectory& objects,
+                                   const ClassLayouts&    classLayouts,
+                                   const ClassDumpTable&  classDumps,
+                                   size_t                 threads = 1,
+                                   GzipWindowCache*       windows = nullptr);
+
+// graph with every reference reversed, built on up to `threads` threads
+ReferenceGraph transposeReferenceGraph(const ReferenceGraph& graph, size_t threads = 1);
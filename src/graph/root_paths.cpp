@@ -0,0 +1,38 @@
+#include <graph/root_paths.h>
+
+#include <algorithm>
+
+RootPaths::RootPaths(const ReferenceGraph& graph, std::span<const ObjectIndex> roots) {
+    parents_.assign(graph.numObjects(), NO_OBJECT);
+
+    // parents double as the visited set, the queue is a plain array as every object enters it at most once
+    std::vector<ObjectIndex> queue;
+    for (const auto root : roots) {
+        if (parents_[root] == NO_OBJECT) {
+            parents_[root] = root;
+            queue.push_back(root);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const ObjectIndex v = queue[head];
+        for (const auto w : graph.references(v)) {
+            if (parents_[w] == NO_OBJECT) {
+                parents_[w] = v;
+                queue.push_back(w);
+            }
+        }
+    }
+}
+
+std::vector<ObjectIndex> RootPaths::pathFromRoot(ObjectIndex index) const {
+    std::vector<ObjectIndex> path;
+    if (!isReachable(index)) {
+        return path;
+    }
+    for (; !isRoot(index); index = parents_[index]) {
+        path.push_back(index);
+    }
+    path.push_back(index);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
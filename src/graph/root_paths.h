@@ -0,0 +1,45 @@
+#pragma once
+
+#include <graph/reference_graph.h>
+#include <index/object_directory.h>
+
+#include <span>
+#include <vector>
+
+// shortest reference chains from GC roots to every reachable object,
+// found with one breadth-first search started from all roots at once
+class RootPaths {
+
+public:
+    RootPaths() = default;
+
+    RootPaths(const ReferenceGraph& graph, std::span<const ObjectIndex> roots);
+
+public:
+    bool isReachable(ObjectIndex index) const {
+        return parents_[index] != NO_OBJECT;
+    }
+
+    bool isRoot(ObjectIndex index) const {
+        return parents_[index] == index;
+    }
+
+    // previous object on a shortest path from a GC root; the object itself for roots, NO_OBJECT if unreachable
+    ObjectIndex parent(ObjectIndex index) const {
+        return parents_[index];
+    }
+
+    // objects from a GC root to the given one, both included; empty if unreachable
+    std::vector<ObjectIndex> pathFromRoot(ObjectIndex index) const;
+
+    size_t size() const {
+        return parents_.size();
+    }
+
+    size_t memoryBytes() const {
+        return parents_.capacity() * sizeof(ObjectIndex);
+    }
+
+private:
+    std::vector<ObjectIndex> parents_;
+};
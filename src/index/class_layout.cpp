@@ -0,0 +1,39 @@
+#include <index/class_layout.h>
+
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+ClassLayouts buildClassLayouts(const ClassDumpTable&      classDumps,
+                               const StringTable&         strings,
+                               size_t                     identifierSize,
+                               std::pmr::memory_resource* resource) {
+    ClassLayouts layouts(resource);
+    layouts.reserve(classDumps.size());
+    for (const auto& [classObjectID, classDump] : classDumps) {
+        ClassLayout layout(resource);
+        size_t      offset = 0;
+        size_t      depth  = 0;
+        for (auto id = classObjectID; !isNull(id); id = classDumps.at(id).superclassObjectID) {
+            // a longer chain of superclasses than there are classes has a loop
+            if (++depth > classDumps.size()) {
+                throw std::runtime_error(std::format("corrupt class hierarchy of class {}", formatID(classObjectID)));
+            }
+            for (const auto& field : classDumps.at(id).fields) {
+                const size_t size = basicTypeSize(field.type, identifierSize);
+                layout.fields.push_back({
+                    .nameStringID = field.nameStringID,
+                    .name         = strings.at(field.nameStringID).view,
+                    .ref          = {static_cast<uint32_t>(offset), field.type, static_cast<uint8_t>(size)},
+                });
+                offset += size;
+            }
+        }
+        if (offset > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error(std::format("fields of class {} are too large", formatID(classObjectID)));
+        }
+        layout.fieldsByteSize = static_cast<uint32_t>(offset);
+        layouts.emplace(classObjectID, std::move(layout));
+    }
+    return layouts;
+}
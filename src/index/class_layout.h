@@ -0,0 +1,102 @@
+#pragma once
+
+#include <data/data.h>
+#include <utils/reader.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// position of a field inside the fields block of an instance dump
+struct FieldRef {
+    uint32_t  offset;
+    BasicType type;
+    uint8_t   size;
+};
+
+// instance fields of a class and all of its superclasses, flattened in the order they are dumped:
+// fields of the class itself first, then those of its superclass and so on
+struct ClassLayout {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    struct Field {
+        StringID         nameStringID;
+        std::string_view name;
+        FieldRef         ref;
+    };
+
+    ClassLayout() = default;
+
+    explicit ClassLayout(const allocator_type& allocator)
+      : fields(allocator) {}
+
+    ClassLayout(const ClassLayout& other, const allocator_type& allocator)
+      : fields(other.fields, allocator)
+      , fieldsByteSize(other.fieldsByteSize) {}
+
+    ClassLayout(ClassLayout&& other, const allocator_type& allocator)
+      : fields(std::move(other.fields), allocator)
+      , fieldsByteSize(other.fieldsByteSize) {}
+
+    ClassLayout(const ClassLayout&)            = default;
+    ClassLayout(ClassLayout&&)                 = default;
+    ClassLayout& operator=(const ClassLayout&) = default;
+    ClassLayout& operator=(ClassLayout&&)      = default;
+
+    std::pmr::vector<Field> fields;
+    uint32_t                fieldsByteSize = 0;
+
+    // first field with the given name, i.e. the one declared furthest down the hierarchy
+    std::optional<FieldRef> find(std::string_view name) const {
+        for (const auto& field : fields) {
+            if (field.name == name) {
+                return field.ref;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+using ClassLayouts = std::pmr::unordered_map<ClassObjectID, ClassLayout>;
+
+// field looked up by name once per class, and by class alone after that
+class FieldHandle {
+
+public:
+    explicit FieldHandle(std::string name)
+      : name_(std::move(name)) {}
+
+public:
+    const std::string& name() const {
+        return name_;
+    }
+
+    // ref of the field in instances of the class, nullopt if it has no such field
+    std::optional<FieldRef> resolve(ClassObjectID classObjectID, const ClassLayout& layout) {
+        const auto [it, inserted] = refs_.try_emplace(classObjectID);
+        if (inserted) {
+            it->second = layout.find(name_);
+        }
+        return it->second;
+    }
+
+private:
+    std::string                                                name_;
+    std::unordered_map<ClassObjectID, std::optional<FieldRef>> refs_;
+};
+
+// layouts and their fields are allocated from `resource`
+ClassLayouts buildClassLayouts(const ClassDumpTable&      classDumps,
+                               const StringTable&         strings,
+                               size_t                     identifierSize,
+                               std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// fieldsView must span at least fieldsByteSize of the layout the ref comes from
+inline Value readField(std::span<const std::byte> fieldsView, FieldRef ref) {
+    return loadBigEndian(fieldsView.data() + ref.offset, ref.size);
+}
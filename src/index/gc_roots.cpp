@@ -0,0 +1,79 @@
+#include <index/gc_roots.h>
+
+#include <utils/external_sort.h>
+
+#include <stdexcept>
+#include <utility>
+
+GCRootTable::GCRootTable(Builder&& builder)
+  : ids_(std::move(builder.ids_))
+  , kinds_(std::move(builder.kinds_))
+  , threadSerialNumbers_(std::move(builder.threadSerialNumbers_))
+  , frameNumbers_(std::move(builder.frameNumbers_)) {}
+
+void GCRootTable::save(SidecarWriter& writer) const {
+    writer.add(SidecarSection::GC_ROOT_IDS, ids_.span());
+    writer.add(SidecarSection::GC_ROOT_KINDS, kinds_.span());
+    writer.add(SidecarSection::GC_ROOT_THREADS, threadSerialNumbers_.span());
+    writer.add(SidecarSection::GC_ROOT_FRAMES, frameNumbers_.span());
+}
+
+// roots are few, so they are copied out of the index
+GCRootTable GCRootTable::load(const Sidecar& sidecar) {
+    const auto copy = [&]<typename T>(SidecarSection section, Column<T>& column) {
+        const auto elements = sidecar.section<T>(section);
+        column              = std::vector<T>(elements.begin(), elements.end());
+    };
+    GCRootTable table;
+    copy(SidecarSection::GC_ROOT_IDS, table.ids_);
+    copy(SidecarSection::GC_ROOT_KINDS, table.kinds_);
+    copy(SidecarSection::GC_ROOT_THREADS, table.threadSerialNumbers_);
+    copy(SidecarSection::GC_ROOT_FRAMES, table.frameNumbers_);
+    const size_t n = table.ids_.size();
+    if (table.kinds_.size() != n || table.threadSerialNumbers_.size() != n || table.frameNumbers_.size() != n) {
+        throw std::runtime_error("corrupt GC roots in index");
+    }
+    return table;
+}
+
+GCRootTable::SpillBuilder::SpillBuilder(std::filesystem::path pathPrefix)
+  : pathPrefix_(std::move(pathPrefix)) {
+    for (auto* file : {&idsFile_, &kindsFile_, &threadSerialNumbersFile_, &frameNumbersFile_}) {
+        file->exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    }
+    const auto mode = std::ios_base::binary | std::ios_base::out | std::ios_base::trunc;
+    idsFile_.open(path_("roots.ids"), mode);
+    kindsFile_.open(path_("roots.kinds"), mode);
+    threadSerialNumbersFile_.open(path_("roots.threads"), mode);
+    frameNumbersFile_.open(path_("roots.frames"), mode);
+}
+
+void GCRootTable::SpillBuilder::append(const Builder& roots) {
+    appendToFile(idsFile_, std::span<const ID>(roots.ids_));
+    appendToFile(kindsFile_, std::span<const SubTag>(roots.kinds_));
+    appendToFile(threadSerialNumbersFile_, std::span<const uint32_t>(roots.threadSerialNumbers_));
+    appendToFile(frameNumbersFile_, std::span<const uint32_t>(roots.frameNumbers_));
+}
+
+GCRootTable GCRootTable::SpillBuilder::finish(std::vector<MappedFile>& files) {
+    for (auto* file : {&idsFile_, &kindsFile_, &threadSerialNumbersFile_, &frameNumbersFile_}) {
+        file->close();
+    }
+    const auto map = [&]<typename T>(const char* column, Column<T>& target) {
+        const auto& file = files.emplace_back(MappedFile::temporary(path_(column)));
+        target = Column<T>::view({reinterpret_cast<const T*>(file.data()), file.size() / sizeof(T)});
+    };
+    GCRootTable table;
+    map("roots.ids", table.ids_);
+    map("roots.kinds", table.kinds_);
+    map("roots.threads", table.threadSerialNumbers_);
+    map("roots.frames", table.frameNumbers_);
+    return table;
+}
+
+std::filesystem::path GCRootTable::SpillBuilder::path_(const char* column) const {
+    auto path = pathPrefix_;
+    path += '.';
+    path += column;
+    return path;
+}
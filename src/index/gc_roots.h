@@ -0,0 +1,128 @@
+#pragma once
+
+#include <data/data.h>
+#include <index/sidecar.h>
+#include <utils/column.h>
+#include <utils/fs_utils.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <vector>
+
+// GC roots from all ROOT_* sub-records as a structure of arrays;
+// the same object may be rooted several times, by different kinds of roots
+class GCRootTable {
+
+public:
+    // thread serial number or frame number of roots that don't have one
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    class Builder;
+    class SpillBuilder;
+
+    GCRootTable() = default;
+
+    explicit GCRootTable(Builder&& builder);
+
+    void               save(SidecarWriter& writer) const;
+    static GCRootTable load(const Sidecar& sidecar);
+
+public:
+    size_t size() const {
+        return ids_.size();
+    }
+
+    std::span<const ID> ids() const {
+        return ids_;
+    }
+
+    ID id(size_t i) const {
+        return ids_[i];
+    }
+
+    // ROOT_* sub-tag the root comes from
+    SubTag kind(size_t i) const {
+        return kinds_[i];
+    }
+
+    // of ROOT_JNI_LOCAL, ROOT_JAVA_FRAME, ROOT_NATIVE_STACK, ROOT_THREAD_BLOCK and ROOT_THREAD_OBJECT
+    uint32_t threadSerialNumber(size_t i) const {
+        return threadSerialNumbers_[i];
+    }
+
+    // depth in the stack trace of the thread, of ROOT_JNI_LOCAL and ROOT_JAVA_FRAME
+    uint32_t frameNumber(size_t i) const {
+        return frameNumbers_[i];
+    }
+
+    size_t memoryBytes() const {
+        return ids_.memoryBytes() + kinds_.memoryBytes() + threadSerialNumbers_.memoryBytes() +
+               frameNumbers_.memoryBytes();
+    }
+
+private:
+    Column<ID>       ids_;
+    Column<SubTag>   kinds_;
+    Column<uint32_t> threadSerialNumbers_;
+    Column<uint32_t> frameNumbers_;
+};
+
+// collects roots in memory, in the order they are added
+class GCRootTable::Builder {
+
+public:
+    void add(ID id, SubTag kind, uint32_t threadSerialNumber = NONE, uint32_t frameNumber = NONE) {
+        ids_.push_back(id);
+        kinds_.push_back(kind);
+        threadSerialNumbers_.push_back(threadSerialNumber);
+        frameNumbers_.push_back(frameNumber);
+    }
+
+    void append(const Builder& other) {
+        ids_.insert(ids_.end(), other.ids_.begin(), other.ids_.end());
+        kinds_.insert(kinds_.end(), other.kinds_.begin(), other.kinds_.end());
+        threadSerialNumbers_.insert(
+            threadSerialNumbers_.end(), other.threadSerialNumbers_.begin(), other.threadSerialNumbers_.end());
+        frameNumbers_.insert(frameNumbers_.end(), other.frameNumbers_.begin(), other.frameNumbers_.end());
+    }
+
+    size_t size() const {
+        return ids_.size();
+    }
+
+private:
+    friend class GCRootTable;
+    friend class GCRootTable::SpillBuilder;
+
+    std::vector<ID>       ids_;
+    std::vector<SubTag>   kinds_;
+    std::vector<uint32_t> threadSerialNumbers_;
+    std::vector<uint32_t> frameNumbers_;
+};
+
+// bounded-memory variant of Builder: roots are appended to files and the table views them once mapped
+class GCRootTable::SpillBuilder {
+
+public:
+    // files are named pathPrefix.<column>
+    explicit SpillBuilder(std::filesystem::path pathPrefix);
+
+    void append(const Builder& roots);
+
+    // the table views the files, which are appended to `files` and must stay mapped as long as it is used
+    GCRootTable finish(std::vector<MappedFile>& files);
+
+private:
+    std::filesystem::path path_(const char* column) const;
+
+private:
+    std::filesystem::path pathPrefix_;
+    std::ofstream         idsFile_;
+    std::ofstream         kindsFile_;
+    std::ofstream         threadSerialNumbersFile_;
+    std::ofstream         frameNumbersFile_;
+};
@@ -0,0 +1,182 @@
+#include <index/object_directory.h>
+
+#include <bit>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+const char* objectKindName(ObjectKind kind) {
+    switch (kind) {
+        using enum ObjectKind;
+    case NONE:            return "none";
+    case INSTANCE:        return "instance";
+    case OBJECT_ARRAY:    return "object array";
+    case PRIMITIVE_ARRAY: return "primitive array";
+    case CLASS:           return "class";
+    }
+    throw std::runtime_error("unreachable code");
+}
+
+ObjectDirectory::ObjectDirectory(std::span<const std::vector<Entry>> entries) {
+    size_t total = 0;
+    for (const auto& part : entries) {
+        total += part.size();
+    }
+    if (total >= NO_OBJECT) {
+        throw std::runtime_error(std::format("too many objects in heap ({})", total));
+    }
+
+    // keep the load factor between 1/3 and 2/3
+    const size_t             capacity = std::bit_ceil(total + total / 2 + 1);
+    std::vector<ObjectIndex> slots(capacity, NO_OBJECT);
+    std::vector<ID>          ids;
+    std::vector<uint64_t>    locations;
+    mask_ = capacity - 1;
+    ids.reserve(total);
+    locations.reserve(total);
+
+    for (const auto& part : entries) {
+        for (const auto& entry : part) {
+            if (entry.id == 0) {
+                continue;
+            }
+            for (size_t i = hash_(entry.id) & mask_;; i = (i + 1) & mask_) {
+                ObjectIndex& slot = slots[i];
+                if (slot == NO_OBJECT) {
+                    slot = static_cast<ObjectIndex>(ids.size());
+                    ids.push_back(entry.id);
+                    locations.push_back(entry.location);
+                    break;
+                }
+                if (ids[slot] == entry.id) {
+                    break;
+                }
+            }
+        }
+    }
+    slots_     = std::move(slots);
+    ids_       = std::move(ids);
+    locations_ = std::move(locations);
+}
+
+void ObjectDirectory::save(SidecarWriter& writer) const {
+    writer.add(sortedSlots_ ? SidecarSection::OBJECT_SORTED_SLOTS : SidecarSection::OBJECT_SLOTS, slots_.span());
+    writer.add(SidecarSection::OBJECT_IDS, ids_.span());
+    writer.add(SidecarSection::OBJECT_LOCATIONS, locations_.span());
+}
+
+ObjectDirectory ObjectDirectory::load(const Sidecar& sidecar) {
+    ObjectDirectory directory;
+    directory.sortedSlots_ = sidecar.contains(SidecarSection::OBJECT_SORTED_SLOTS);
+    directory.slots_       = Column<ObjectIndex>::view(sidecar.section<ObjectIndex>(
+        directory.sortedSlots_ ? SidecarSection::OBJECT_SORTED_SLOTS : SidecarSection::OBJECT_SLOTS));
+    directory.ids_       = Column<ID>::view(sidecar.section<ID>(SidecarSection::OBJECT_IDS));
+    directory.locations_ = Column<uint64_t>::view(sidecar.section<uint64_t>(SidecarSection::OBJECT_LOCATIONS));
+    const bool validSlots =
+        directory.sortedSlots_
+            ? directory.slots_.size() <= directory.ids_.size()
+            : std::has_single_bit(directory.slots_.size()) && directory.ids_.size() < directory.slots_.size();
+    if (!validSlots || directory.ids_.size() != directory.locations_.size()) {
+        throw std::runtime_error("corrupt object directory in index");
+    }
+
+    // the index has no checksum, so everything later used as an array index or a kind is checked once here;
+    // probing stops at empty slots, so the hash table must have one
+    bool hasEmptySlot = false;
+    for (const auto slot : directory.slots_) {
+        if (!directory.sortedSlots_ && slot == NO_OBJECT) {
+            hasEmptySlot = true;
+        } else if (slot >= directory.ids_.size()) {
+            throw std::runtime_error("corrupt object directory in index");
+        }
+    }
+    if (!directory.sortedSlots_ && !hasEmptySlot) {
+        throw std::runtime_error("corrupt object directory in index");
+    }
+    for (const auto location : directory.locations_) {
+        const auto kind = static_cast<ObjectKind>(location & 0xFF);
+        if (kind == ObjectKind::NONE || kind > ObjectKind::CLASS) {
+            throw std::runtime_error("corrupt object directory in index");
+        }
+    }
+
+    directory.mask_ = directory.sortedSlots_ ? 0 : directory.slots_.size() - 1;
+    return directory;
+}
+
+ObjectDirectory::SpillBuilder::SpillBuilder(std::filesystem::path pathPrefix, size_t memoryBudgetBytes)
+  : pathPrefix_(std::move(pathPrefix))
+  , slots_(pathPrefix_, memoryBudgetBytes) {
+    for (auto* file : {&idsFile_, &locationsFile_}) {
+        file->exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    }
+    idsFile_.open(path_("ids"), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    locationsFile_.open(path_("locations"), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+}
+
+void ObjectDirectory::SpillBuilder::add(std::span<const Entry> entries) {
+    std::vector<ID>       ids;
+    std::vector<uint64_t> locations;
+    ids.reserve(entries.size());
+    locations.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (entry.id == 0) {
+            continue;
+        }
+        if (size_ + ids.size() >= NO_OBJECT) {
+            throw std::runtime_error(std::format("too many objects in heap ({})", size_ + ids.size() + 1));
+        }
+        slots_.add({entry.id, static_cast<ObjectIndex>(size_ + ids.size())});
+        ids.push_back(entry.id);
+        locations.push_back(entry.location);
+    }
+    appendToFile(idsFile_, std::span<const ID>(ids));
+    appendToFile(locationsFile_, std::span<const uint64_t>(locations));
+    size_ += ids.size();
+}
+
+ObjectDirectory ObjectDirectory::SpillBuilder::finish(std::vector<MappedFile>& files) {
+    idsFile_.close();
+    locationsFile_.close();
+    {
+        std::ofstream fout;
+        fout.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        fout.open(path_("slots"), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+
+        constexpr size_t         BLOCK_SIZE = size_t{1} << 16;
+        std::vector<ObjectIndex> block;
+        block.reserve(BLOCK_SIZE);
+        ID last = 0;
+        slots_.merge([&](const SortedSlot_& slot) {
+            // stable, so the first object with an ID comes first
+            if (slot.id == last) {
+                return;
+            }
+            last = slot.id;
+            block.push_back(slot.index);
+            if (block.size() == BLOCK_SIZE) {
+                appendToFile(fout, std::span<const ObjectIndex>(block));
+                block.clear();
+            }
+        });
+        appendToFile(fout, std::span<const ObjectIndex>(block));
+    }
+
+    const auto map = [&]<typename T>(const char* table, Column<T>& column) {
+        const auto& file = files.emplace_back(MappedFile::temporary(path_(table)));
+        column = Column<T>::view({reinterpret_cast<const T*>(file.data()), file.size() / sizeof(T)});
+    };
+    ObjectDirectory directory;
+    map("slots", directory.slots_);
+    map("ids", directory.ids_);
+    map("locations", directory.locations_);
+    directory.sortedSlots_ = true;
+    return directory;
+}
+
+std::filesystem::path ObjectDirectory::SpillBuilder::path_(const char* table) const {
+    auto path = pathPrefix_;
+    path += '.';
+    path += table;
+    return path;
+}
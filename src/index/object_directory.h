@@ -0,0 +1,188 @@
+#pragma once
+
+#include <data/data.h>
+#include <index/sidecar.h>
+#include <utils/column.h>
+#include <utils/external_sort.h>
+#include <utils/fs_utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+enum class ObjectKind : uint8_t {
+    NONE            = 0,
+    INSTANCE        = 1,
+    OBJECT_ARRAY    = 2,
+    PRIMITIVE_ARRAY = 3,
+    CLASS           = 4,
+};
+
+const char* objectKindName(ObjectKind kind);
+
+struct ObjectLocation {
+    ObjectKind kind;
+    size_t     offset; // of the sub-record body, from the beginning of the dump reader
+};
+
+// dense index of a heap object, assigned in dump order; usable directly as an array index
+using ObjectIndex = uint32_t;
+
+static constexpr ObjectIndex NO_OBJECT = std::numeric_limits<ObjectIndex>::max();
+
+// every object in the heap (instances, arrays and classes) numbered densely in dump order,
+// with their IDs and sub-record locations in plain arrays by index,
+// plus an open-addressing hash table with linear probing for ID -> index,
+// or, if built by a SpillBuilder, an array of the same slots sorted by ID;
+// slots only hold the index, the ID they stand for is looked up in the ID array
+class ObjectDirectory {
+
+public:
+    class SpillBuilder;
+
+    struct Entry {
+        ID       id;
+        uint64_t location; // offset << 8 | kind
+    };
+
+    static Entry makeEntry(ID id, ObjectKind kind, size_t offset) {
+        return {id, static_cast<uint64_t>(offset) << 8 | static_cast<uint8_t>(kind)};
+    }
+
+    ObjectDirectory() = default;
+
+    // indices follow the order of entries; on duplicate IDs the first entry wins
+    explicit ObjectDirectory(std::span<const std::vector<Entry>> entries);
+
+    // tables are saved as they are and used in place from the mapped index on load
+    void                   save(SidecarWriter& writer) const;
+    static ObjectDirectory load(const Sidecar& sidecar);
+
+public:
+    ObjectIndex indexOf(ID id) const {
+        if (id == 0 || slots_.empty()) {
+            return NO_OBJECT;
+        }
+        if (sortedSlots_) {
+            const auto it = std::lower_bound(
+                slots_.begin(), slots_.end(), id, [&](ObjectIndex slot, ID key) { return ids_[slot] < key; });
+            return it != slots_.end() && ids_[*it] == id ? *it : NO_OBJECT;
+        }
+        for (size_t i = hash_(id) & mask_;; i = (i + 1) & mask_) {
+            const ObjectIndex slot = slots_[i];
+            if (slot == NO_OBJECT) {
+                return NO_OBJECT;
+            }
+            if (ids_[slot] == id) {
+                return slot;
+            }
+        }
+    }
+
+    std::optional<ObjectLocation> find(ID id) const {
+        const auto index = indexOf(id);
+        if (index == NO_OBJECT) {
+            return std::nullopt;
+        }
+        return location(index);
+    }
+
+    ObjectKind kind(ID id) const {
+        const auto index = indexOf(id);
+        return index != NO_OBJECT ? kind(index) : ObjectKind::NONE;
+    }
+
+    bool contains(ID id) const {
+        return indexOf(id) != NO_OBJECT;
+    }
+
+    ID id(ObjectIndex index) const {
+        return ids_[index];
+    }
+
+    ObjectKind kind(ObjectIndex index) const {
+        return static_cast<ObjectKind>(locations_[index] & 0xFF);
+    }
+
+    ObjectLocation location(ObjectIndex index) const {
+        return {kind(index), locations_[index] >> 8};
+    }
+
+    size_t size() const {
+        return ids_.size();
+    }
+
+    size_t memoryBytes() const {
+        return slots_.memoryBytes() + ids_.memoryBytes() + locations_.memoryBytes();
+    }
+
+    // f(ObjectIndex) for every object, in dump order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (ObjectIndex i = 0; i < ids_.size(); ++i) {
+            f(i);
+        }
+    }
+
+private:
+    // slot with its ID, as sorted by a SpillBuilder
+    struct SortedSlot_ {
+        ID          id;
+        ObjectIndex index;
+    };
+
+    struct SlotIDLess_ {
+        bool operator()(const SortedSlot_& a, const SortedSlot_& b) const {
+            return a.id < b.id;
+        }
+    };
+
+    static uint64_t hash_(ID id) {
+        // murmur3 finalizer, object IDs are addresses and have poor low bits
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdULL;
+        id ^= id >> 33;
+        id *= 0xc4ceb9fe1a85ec53ULL;
+        id ^= id >> 33;
+        return id;
+    }
+
+private:
+    Column<ObjectIndex> slots_; // NO_OBJECT marks an empty slot
+    size_t              mask_        = 0;
+    bool                sortedSlots_ = false;
+    Column<ID>          ids_;
+    Column<uint64_t>    locations_;
+};
+
+// builds a directory of more objects than fit in memory: IDs and locations are appended to files as they come
+// and the slots are sorted by ID with an external sort instead of being hashed;
+// unlike in memory, objects with duplicate IDs all get an index, but only the first one is found by ID
+class ObjectDirectory::SpillBuilder {
+
+public:
+    // files are named pathPrefix.<table>, the sort buffers take up to memoryBudgetBytes
+    SpillBuilder(std::filesystem::path pathPrefix, size_t memoryBudgetBytes);
+
+    // entries must come in dump order
+    void add(std::span<const Entry> entries);
+
+    // the directory views the files, which are appended to `files` and must stay mapped as long as it is used
+    ObjectDirectory finish(std::vector<MappedFile>& files);
+
+private:
+    std::filesystem::path path_(const char* table) const;
+
+private:
+    std::filesystem::path                    pathPrefix_;
+    std::ofstream                            idsFile_;
+    std::ofstream                            locationsFile_;
+    ExternalSorter<SortedSlot_, SlotIDLess_> slots_;
+    size_t                                   size_ = 0;
+};
@@ -0,0 +1,117 @@
+#include <index/sidecar.h>
+
+#include <array>
+#include <fstream>
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC   = {'H', 'P', 'R', 'O', 'F', 'I', 'D', 'X'};
+constexpr uint32_t            VERSION = 3;
+
+// written in native byte order, so that an index is not used on a machine of other endianness
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// sections start at multiples of this, which covers the alignment of every array type
+constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    uint32_t            version;
+    uint32_t            byteOrderMark;
+    uint64_t            dumpSize;
+    uint64_t            dumpMillis;
+    uint32_t            identifierSize;
+    uint32_t            numSections;
+};
+
+struct SectionEntry {
+    uint32_t section;
+    uint32_t reserved;
+    uint64_t offset; // from the beginning of the file
+    uint64_t size;
+};
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+} // namespace
+
+std::filesystem::path sidecarPath(const std::filesystem::path& dumpFile) {
+    auto path = dumpFile;
+    path += ".idx";
+    return path;
+}
+
+void SidecarWriter::write(const std::filesystem::path& path) const {
+    const FileHeader header{.magic          = MAGIC,
+                            .version        = VERSION,
+                            .byteOrderMark  = BYTE_ORDER_MARK,
+                            .dumpSize       = key_.dumpSize,
+                            .dumpMillis     = key_.dumpMillis,
+                            .identifierSize = key_.identifierSize,
+                            .numSections    = static_cast<uint32_t>(sections_.size())};
+
+    std::vector<SectionEntry> entries;
+    uint64_t                  offset = alignUp(sizeof(FileHeader) + sections_.size() * sizeof(SectionEntry));
+    for (const auto& [section, bytes] : sections_) {
+        entries.push_back({static_cast<uint32_t>(section), 0, offset, bytes.size()});
+        offset = alignUp(offset + bytes.size());
+    }
+
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream fout;
+        fout.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        fout.open(tmpPath, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SectionEntry));
+
+        const std::array<char, SECTION_ALIGNMENT> padding{};
+        uint64_t                                  written = sizeof(header) + entries.size() * sizeof(SectionEntry);
+        size_t                                    i       = 0;
+        for (const auto& [section, bytes] : sections_) {
+            fout.write(padding.data(), entries[i].offset - written);
+            fout.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            written = entries[i].offset + bytes.size();
+            ++i;
+        }
+    }
+    std::filesystem::rename(tmpPath, path);
+}
+
+std::optional<Sidecar> Sidecar::open(const std::filesystem::path& path, const SidecarKey& key) {
+    if (!std::filesystem::is_regular_file(path)) {
+        return std::nullopt;
+    }
+
+    Sidecar sidecar;
+    sidecar.file_    = MappedFile(path);
+    const auto* data = sidecar.file_.data();
+    const auto  size = sidecar.file_.size();
+    if (size < sizeof(FileHeader)) {
+        return std::nullopt;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION || header.byteOrderMark != BYTE_ORDER_MARK ||
+        header.dumpSize != key.dumpSize || header.dumpMillis != key.dumpMillis ||
+        header.identifierSize != key.identifierSize) {
+        return std::nullopt;
+    }
+    if ((size - sizeof(FileHeader)) / sizeof(SectionEntry) < header.numSections) {
+        return std::nullopt;
+    }
+
+    for (uint32_t i = 0; i < header.numSections; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(entry));
+        if (entry.offset > size || size - entry.offset < entry.size || entry.offset % SECTION_ALIGNMENT != 0) {
+            return std::nullopt;
+        }
+        sidecar.sections_[static_cast<SidecarSection>(entry.section)] = {data + entry.offset, entry.size};
+    }
+    return sidecar;
+}
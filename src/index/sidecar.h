@@ -0,0 +1,183 @@
+#pragma once
+
+#include <utils/fs_utils.h>
+#include <utils/reader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// sections of the sidecar index, arrays are stored in native byte order so that they can be used in place
+enum class SidecarSection : uint32_t {
+    SUMMARY              = 1,
+    RECORD_DIRECTORY     = 2,
+    STRINGS              = 3,
+    LOAD_CLASSES         = 4,
+    CLASS_DUMPS          = 5,
+    CLASS_INSTANCE_COUNT = 6,
+    STACK_FRAMES         = 7,
+    STACK_TRACES         = 8,
+    OBJECT_SLOTS         = 9,
+    OBJECT_IDS           = 10,
+    OBJECT_LOCATIONS     = 11,
+    GC_ROOT_IDS          = 12,
+    GC_ROOT_KINDS        = 13,
+    GC_ROOT_THREADS      = 14,
+    GC_ROOT_FRAMES       = 15,
+    REFERENCE_OFFSETS    = 16,
+    REFERENCE_TARGETS    = 17,
+    IMMEDIATE_DOMINATORS = 18,
+    DOMINATOR_REACHABLE  = 19,
+    RETAINED_SIZES       = 20,
+    OBJECT_SORTED_SLOTS  = 21,
+    GZIP_INDEX           = 22,
+    GZIP_CHECKPOINTS     = 23,
+    STRING_CONTENTS      = 24,
+};
+
+// what an index is checked against before it is used for a dump
+struct SidecarKey {
+    uint64_t dumpSize; // of the file, compressed or not
+    uint64_t dumpMillis;
+    uint32_t identifierSize;
+};
+
+// <dump>.idx next to the dump
+std::filesystem::path sidecarPath(const std::filesystem::path& dumpFile);
+
+// collects sections and writes them as a sidecar index
+class SidecarWriter {
+
+public:
+    explicit SidecarWriter(const SidecarKey& key)
+      : key_(key) {}
+
+public:
+    // the elements are only copied on write, so they must outlive the writer
+    template <typename T>
+    void add(SidecarSection section, std::span<T> elements) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        sections_[section] = std::as_bytes(elements);
+    }
+
+    void add(SidecarSection section, std::vector<std::byte> bytes) {
+        add(section, std::span<const std::byte>(blobs_.emplace_back(std::move(bytes))));
+    }
+
+    // writes to a temporary file that then replaces path, so a partially written index is never picked up
+    void write(const std::filesystem::path& path) const;
+
+private:
+    SidecarKey                                           key_;
+    std::map<SidecarSection, std::span<const std::byte>> sections_;
+    std::vector<std::vector<std::byte>>                  blobs_;
+};
+
+// mapped sidecar index; sections are used in place, so the index must outlive everything loaded from it
+class Sidecar {
+
+public:
+    // nullopt if there is no index at path, or it was written for another dump or by another version
+    static std::optional<Sidecar> open(const std::filesystem::path& path, const SidecarKey& key);
+
+public:
+    bool contains(SidecarSection section) const {
+        return sections_.contains(section);
+    }
+
+    std::span<const std::byte> bytes(SidecarSection section) const {
+        const auto it = sections_.find(section);
+        if (it == sections_.end()) {
+            throw std::runtime_error(std::format("index has no section {}", static_cast<uint32_t>(section)));
+        }
+        return it->second;
+    }
+
+    template <typename T>
+    std::span<const T> section(SidecarSection section) const {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto sectionBytes = bytes(section);
+        if (sectionBytes.size() % sizeof(T) != 0 ||
+            reinterpret_cast<uintptr_t>(sectionBytes.data()) % alignof(T) != 0) {
+            throw std::runtime_error(std::format("corrupt section {} in index", static_cast<uint32_t>(section)));
+        }
+        return {reinterpret_cast<const T*>(sectionBytes.data()), sectionBytes.size() / sizeof(T)};
+    }
+
+private:
+    MappedFile                                           file_;
+    std::map<SidecarSection, std::span<const std::byte>> sections_;
+};
+
+// packs variable-sized tables into a single section
+class SidecarBlobWriter {
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto valueBytes = std::as_bytes(std::span(&value, 1));
+        bytes_.insert(bytes_.end(), valueBytes.begin(), valueBytes.end());
+    }
+
+    template <typename T>
+    void putArray(std::span<T> elements) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        put<uint64_t>(elements.size());
+        const auto elementsBytes = std::as_bytes(elements);
+        bytes_.insert(bytes_.end(), elementsBytes.begin(), elementsBytes.end());
+    }
+
+    std::vector<std::byte> take() {
+        return std::move(bytes_);
+    }
+
+private:
+    std::vector<std::byte> bytes_;
+};
+
+// reads back what SidecarBlobWriter packed, in the same order
+class SidecarBlobReader {
+
+public:
+    explicit SidecarBlobReader(std::span<const std::byte> bytes)
+      : r_(bytes.data(), bytes.size()) {}
+
+public:
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, r_.skip(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    // elements are allocated with `allocator` rebound to T, e.g. with that of the table they are loaded into
+    template <typename T, typename Allocator = std::allocator<T>>
+    auto getArray(const Allocator& allocator = {}) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        using ElementAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+        const auto size        = get<uint64_t>();
+        if (size > r_.size() / sizeof(T)) {
+            throw std::runtime_error("out of bounds read");
+        }
+        std::vector<T, ElementAllocator> elements(size, ElementAllocator(allocator));
+        const auto bytes = r_.skip(size * sizeof(T));
+        if (size != 0) { // data() of an empty vector may be null
+            std::memcpy(elements.data(), bytes.data(), size * sizeof(T));
+        }
+        return elements;
+    }
+
+private:
+    R r_;
+};
@@ -1,4 +1,34 @@
 #include <parse/parse.h>
+#include <parse/visit.h>
+
+#include <utils/parallel.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// tag, micros and body length
+constexpr size_t RECORD_HEADER_SIZE = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+
+// fixed-size parts of the dynamic sub-records, which are bounds-checked once and then decoded unchecked
+size_t classDumpHeadSize(size_t identifierSize) {
+    return 7 * identifierSize + 2 * sizeof(uint32_t);
+}
+
+size_t instanceDumpHeadSize(size_t identifierSize) {
+    return 2 * identifierSize + 2 * sizeof(uint32_t);
+}
+
+size_t objectArrayDumpHeadSize(size_t identifierSize) {
+    return 2 * identifierSize + 2 * sizeof(uint32_t);
+}
+
+size_t primitiveArrayDumpHeadSize(size_t identifierSize) {
+    return identifierSize + 2 * sizeof(uint32_t) + sizeof(uint8_t);
+}
+
+} // namespace
 
 DumpSummary summarizeDump(R r, size_t identifierSize) {
     DumpSummary summary;
@@ -8,42 +38,16 @@ DumpSummary summarizeDump(R r, size_t identifierSize) {
         case Tag::HEAP_DUMP:
         case Tag::HEAP_DUMP_SEGMENT: {
             R dr(r.it(), recordHeader.bodyByteSize);
-            while (!dr.eof()) {
-                const SubTag subTag = validateSubTag(dr.read<uint8_t>());
+            withIdentifierSize(identifierSize, [&](auto idSize) {
+                while (!dr.eof()) {
+                    const SubTag subTag = validateSubTag(dr.read<uint8_t>());
 
-                ++summary.subTagCounts[subTag];
-                summary.numSubtags++;
+                    ++summary.subTagCounts[subTag];
+                    summary.numSubtags++;
 
-                const size_t subRecordBodySizeBytes = subTagSize(subTag, identifierSize);
-
-                if (subRecordBodySizeBytes != DYNAMIC) {
-                    dr.skip(subRecordBodySizeBytes);
-                    continue;
-                }
-
-                switch (subTag) {
-                    using enum SubTag;
-                case CLASS_DUMP: {
-                    skipClassDump(dr, identifierSize);
-                    break;
-                }
-                case INSTANCE_DUMP: {
-                    skipInstanceDump(dr, identifierSize);
-                    break;
-                }
-                case OBJECT_ARRAY_DUMP: {
-                    skipObjectArrayDump(dr, identifierSize);
-                    break;
-                }
-                case PRIMITIVE_ARRAY_DUMP: {
-                    skipPrimitiveArrayDump(dr, identifierSize);
-                    break;
+                    skipSubRecord(dr, subTag, idSize);
                 }
-                default:
-                    throw std::runtime_error(std::format(
-                        "unexpected dynamic sub-tag {} (0x{:02X})", subTagName(subTag), static_cast<uint8_t>(subTag)));
-                }
-            }
+            });
             r.skip(recordHeader.bodyByteSize);
             if (dr.it() != r.it()) {
                 throw std::runtime_error("specified and actual record body sizes differ");
@@ -74,121 +78,143 @@ RecordHeader parseRecordHeader(R& r) {
     return recordHeader;
 }
 
-void parseDumpBody(R r, const std::unordered_map<Tag, TagHandler>& tagHandlers) {
-    while (!r.eof()) {
-        const auto recordHeader = parseRecordHeader(r);
-        const auto it           = tagHandlers.find(recordHeader.tag);
+void parseDumpBody(DumpBody body, const std::unordered_map<Tag, TagHandler>& tagHandlers) {
+    if (body.directory != nullptr) {
+        for (const auto& [tag, handler] : tagHandlers) {
+            const auto it = body.directory->records.find(tag);
+            if (it == body.directory->records.end()) {
+                continue;
+            }
+            for (const auto& location : it->second) {
+                R br = body.reader.at(location.offset, location.bodyByteSize);
+                handler(br, RecordHeader{tag, location.micros, location.bodyByteSize});
+            }
+        }
+        return;
+    }
+
+    visitDumpBody(body, [&](auto, R& r, const RecordHeader& recordHeader) {
+        const auto it = tagHandlers.find(recordHeader.tag);
         if (it != tagHandlers.end()) {
             auto& handler = it->second;
             handler(r, recordHeader);
         } else {
             r.skip(recordHeader.bodyByteSize);
         }
-    }
+    });
 }
 
-std::unordered_map<StringID, StringInUTF8> parseStrings(R reader, size_t identifierSize) {
-    std::unordered_map<StringID, StringInUTF8> strings;
-    const std::unordered_map<Tag, TagHandler>  handlers = {
-        {Tag::STRING_IN_UTF8,
-         [&](R& r, const RecordHeader& recordHeader) {
-             StringInUTF8 s;
-             r.read(s.id, identifierSize);
-             const auto data = r.skip(recordHeader.bodyByteSize - identifierSize);
-             s.view          = {reinterpret_cast<const char*>(data.data()), data.size_bytes()};
-             strings.insert({s.id, s});
-         }},
-    };
-    parseDumpBody(reader, handlers);
+StringInUTF8 parseStringInUTF8(R& r, const RecordHeader& recordHeader, size_t identifierSize) {
+    StringInUTF8 s;
+    r.read(s.id, identifierSize);
+    const auto data = r.skip(recordHeader.bodyByteSize - identifierSize);
+    s.view          = {reinterpret_cast<const char*>(data.data()), data.size_bytes()};
+    return s;
+}
+
+StringTable parseStrings(DumpBody body, size_t identifierSize) {
+    StringTable strings;
+    visitDumpBody(body, [&](TagConstant<Tag::STRING_IN_UTF8>, R& r, const RecordHeader& recordHeader) {
+        const auto s = parseStringInUTF8(r, recordHeader, identifierSize);
+        strings.insert({s.id, s});
+    });
     return strings;
 }
 
-std::unordered_map<ClassObjectID, LoadClass> parseLoadClasses(R reader, const DumpHeader& dumpHeader) {
-    std::unordered_map<ClassObjectID, LoadClass> loadClasses;
-    const std::unordered_map<Tag, TagHandler>    handlers = {
-        {Tag::LOAD_CLASS,
-         [&](R& r, const RecordHeader&) {
-             LoadClass c;
-             r.read(c.classSerialNumber);
-             r.read(c.classObjectID, dumpHeader.identifierSize);
-             r.read(c.stackTraceSerialNumber);
-             r.read(c.nameStringID, dumpHeader.identifierSize);
-             loadClasses.insert({c.classObjectID, c});
-         }},
-    };
-    parseDumpBody(reader, handlers);
+LoadClass parseLoadClass(R& r, size_t identifierSize) {
+    LoadClass c;
+    r.read(c.classSerialNumber);
+    r.read(c.classObjectID, identifierSize);
+    r.read(c.stackTraceSerialNumber);
+    r.read(c.nameStringID, identifierSize);
+    return c;
+}
+
+LoadClassTable parseLoadClasses(DumpBody body, const DumpHeader& dumpHeader) {
+    LoadClassTable loadClasses;
+    visitDumpBody(body, [&](TagConstant<Tag::LOAD_CLASS>, R& r, const RecordHeader&) {
+        const auto c = parseLoadClass(r, dumpHeader.identifierSize);
+        loadClasses.insert({c.classObjectID, c});
+    });
     return loadClasses;
 }
 
-void skipClassDump(R& r, size_t identifierSize) {
-    r.skip(identifierSize + 4 + identifierSize * 6 + 4);
+template <typename IDSize>
+void skipClassDump(R& r, IDSize identifierSize) {
+    r.skip(classDumpHeadSize(identifierSize));
 
     const auto nConstants = r.read<uint16_t>();
     for (size_t i = 0; i < nConstants; ++i) {
         r.skip(2);
         const auto type = validateBasicType(r.read<uint8_t>());
-        r.skip(basicTypeSize(type));
+        r.skip(basicTypeSize(type, identifierSize));
     }
 
     const auto nStatics = r.read<uint16_t>();
     for (size_t i = 0; i < nStatics; ++i) {
         r.skip(identifierSize);
         const auto type = validateBasicType(r.read<uint8_t>());
-        r.skip(basicTypeSize(type));
+        r.skip(basicTypeSize(type, identifierSize));
     }
 
     const auto nFields = r.read<uint16_t>();
     r.skip((identifierSize + 1) * nFields);
 }
 
-void skipInstanceDump(R& r, size_t identifierSize) {
-    r.skip(identifierSize + 4 + identifierSize);
-    const auto fieldsSizeBytes = r.read<uint32_t>();
+template <typename IDSize>
+void skipInstanceDump(R& r, IDSize identifierSize) {
+    UncheckedR head = r.validated(instanceDumpHeadSize(identifierSize));
+    head.skip(identifierSize + 4 + identifierSize);
+    const auto fieldsSizeBytes = head.read<uint32_t>();
     r.skip(fieldsSizeBytes);
 }
 
-void skipObjectArrayDump(R& r, size_t identifierSize) {
-    r.skip(identifierSize + 4);
-    const auto nElements = r.read<uint32_t>();
-    r.skip(identifierSize + identifierSize * nElements);
+template <typename IDSize>
+void skipObjectArrayDump(R& r, IDSize identifierSize) {
+    UncheckedR head = r.validated(objectArrayDumpHeadSize(identifierSize));
+    head.skip(identifierSize + 4);
+    const auto nElements = head.read<uint32_t>();
+    r.skip(identifierSize * nElements);
+}
+
+template <typename IDSize>
+void skipPrimitiveArrayDump(R& r, IDSize identifierSize) {
+    UncheckedR head = r.validated(primitiveArrayDumpHeadSize(identifierSize));
+    head.skip(identifierSize + 4);
+    const auto nElements = head.read<uint32_t>();
+    const auto type      = validateBasicType(head.read<uint8_t>());
+    r.skip(basicTypeSize(type, identifierSize) * nElements);
 }
 
-void skipPrimitiveArrayDump(R& r, size_t identifierSize) {
-    r.skip(identifierSize + 4);
-    const auto nElements = r.read<uint32_t>();
-    const auto type      = validateBasicType(r.read<uint8_t>());
-    r.skip(basicTypeSize(type) * nElements);
+template <typename IDSize>
+void skipSubRecord(R& r, SubTag subTag, IDSize identifierSize) {
+    const size_t subRecordBodySize = subTagSize(subTag, identifierSize);
+    if (subRecordBodySize != DYNAMIC) {
+        r.skip(subRecordBodySize);
+        return;
+    }
+    switch (subTag) {
+        using enum SubTag;
+    case CLASS_DUMP:           skipClassDump(r, identifierSize); break;
+    case INSTANCE_DUMP:        skipInstanceDump(r, identifierSize); break;
+    case OBJECT_ARRAY_DUMP:    skipObjectArrayDump(r, identifierSize); break;
+    case PRIMITIVE_ARRAY_DUMP: skipPrimitiveArrayDump(r, identifierSize); break;
+    default:
+        throw std::runtime_error(std::format(
+            "unexpected dynamic sub-tag {} (0x{:02X})", subTagName(subTag), static_cast<uint8_t>(subTag)));
+    }
 }
 
 void parseHeapDumpSegment(R& reader, size_t identifierSize,
                           const std::unordered_map<SubTag, SubTagHandler>& subTagHandlers) {
-    static const std::unordered_map<SubTag, SubTagHandler> defaultDynamicSubTagHandlers = {
-        {          SubTag::CLASS_DUMP,          [=](R& r) { skipClassDump(r, identifierSize); }},
-        {       SubTag::INSTANCE_DUMP,       [=](R& r) { skipInstanceDump(r, identifierSize); }},
-        {   SubTag::OBJECT_ARRAY_DUMP,    [=](R& r) { skipObjectArrayDump(r, identifierSize); }},
-        {SubTag::PRIMITIVE_ARRAY_DUMP, [=](R& r) { skipPrimitiveArrayDump(r, identifierSize); }},
-    };
-    while (!reader.eof()) {
-        SubTag subTag = validateSubTag(reader.read<uint8_t>());
+    visitHeapDumpSegment(reader, identifierSize, [&](auto subTag, R& r) {
         if (const auto it = subTagHandlers.find(subTag); it != subTagHandlers.end()) {
             auto& handler = it->second;
-            handler(reader);
+            handler(r);
         } else {
-            size_t subRecordBodySize = subTagSize(subTag, identifierSize);
-            if (subRecordBodySize == DYNAMIC) {
-                if (const auto it_ = defaultDynamicSubTagHandlers.find(subTag);
-                    it_ != defaultDynamicSubTagHandlers.end()) {
-                    auto& defaultHandler = it_->second;
-                    defaultHandler(reader);
-                } else {
-                    throw std::runtime_error(std::format(
-                        "unexpected dynamic sub-tag {} (0x{:02X})", subTagName(subTag), static_cast<uint8_t>(subTag)));
-                }
-            } else {
-                reader.skip(subRecordBodySize);
-            }
+            skipSubRecord(r, subTag, identifierSize);
         }
-    }
+    });
 }
 
 std::function<void(R&, const RecordHeader&)>
@@ -203,256 +229,733 @@ createHeapDumpSegmentHandler(size_t identifierSize, const std::unordered_map<Sub
     };
 }
 
-std::unordered_map<ClassObjectID, ClassDump> parseClassDumps(R reader, size_t identifierSize) {
-    std::unordered_map<ClassObjectID, ClassDump>    classDumps;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::CLASS_DUMP, [&](R& r) {
-             ClassDump cd;
-             r.read(cd.classObjectID, identifierSize);
-             r.read(cd.stackTrackeSerialNumber);
-             r.read(cd.superclassObjectID, identifierSize);
-             r.read(cd.classLoaderObjectID, identifierSize);
-             r.read(cd.signersObjectID, identifierSize);
-             r.read(cd.protectionDomainObjectID, identifierSize);
-             r.skip(identifierSize * 2); // reserved
-             r.read(cd.instanceSizeBytes);
-
-             const auto nConstants = r.read<uint16_t>();
-             for (size_t i = 0; i < nConstants; ++i) {
-                 ClassDump::Constant c;
-                 r.read(c.constantPoolIndex);
-                 c.type = validateBasicType(r.read<uint8_t>());
-                 r.read(c.value, basicTypeSize(c.type));
-                 cd.constants.push_back(std::move(c));
-             }
-             const auto nStatics = r.read<uint16_t>();
-             for (size_t i = 0; i < nStatics; ++i) {
-                 ClassDump::Static s;
-                 r.read(s.nameStringID, identifierSize);
-                 s.type = validateBasicType(r.read<uint8_t>());
-                 r.read(s.value, basicTypeSize(s.type));
-                 cd.statics.push_back(std::move(s));
-             }
-
-             const auto nFields = r.read<uint16_t>();
-             for (size_t i = 0; i < nFields; ++i) {
-                 ClassDump::Field f;
-                 r.read(f.nameStringID, identifierSize);
-                 f.type = validateBasicType(r.read<uint8_t>());
-                 cd.fields.push_back(std::move(f));
-             }
-
-             const auto id = cd.classObjectID;
-             classDumps.insert({id, std::move(cd)});
-         }}
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+template <typename IDSize>
+ClassDump parseClassDump(R& r, IDSize identifierSize, const ClassDump::allocator_type& allocator) {
+    ClassDump  cd(allocator);
+    UncheckedR head = r.validated(classDumpHeadSize(identifierSize));
+    head.read(cd.classObjectID, identifierSize);
+    head.read(cd.stackTrackeSerialNumber);
+    head.read(cd.superclassObjectID, identifierSize);
+    head.read(cd.classLoaderObjectID, identifierSize);
+    head.read(cd.signersObjectID, identifierSize);
+    head.read(cd.protectionDomainObjectID, identifierSize);
+    head.skip(identifierSize * 2); // reserved
+    head.read(cd.instanceSizeBytes);
+
+    const auto nConstants = r.read<uint16_t>();
+    for (size_t i = 0; i < nConstants; ++i) {
+        ClassDump::Constant c;
+        r.read(c.constantPoolIndex);
+        c.type = validateBasicType(r.read<uint8_t>());
+        r.read(c.value, basicTypeSize(c.type, identifierSize));
+        cd.constants.push_back(std::move(c));
+    }
+    const auto nStatics = r.read<uint16_t>();
+    for (size_t i = 0; i < nStatics; ++i) {
+        ClassDump::Static s;
+        r.read(s.nameStringID, identifierSize);
+        s.type = validateBasicType(r.read<uint8_t>());
+        r.read(s.value, basicTypeSize(s.type, identifierSize));
+        cd.statics.push_back(std::move(s));
+    }
+
+    const auto nFields = r.read<uint16_t>();
+    for (size_t i = 0; i < nFields; ++i) {
+        ClassDump::Field f;
+        r.read(f.nameStringID, identifierSize);
+        f.type = validateBasicType(r.read<uint8_t>());
+        cd.fields.push_back(std::move(f));
+    }
+    return cd;
+}
+
+void parseHeapDump(DumpBody body, size_t identifierSize,
+                   const std::unordered_map<SubTag, SubTagHandler>& subTagHandlers) {
+    if (body.directory == nullptr) {
+        const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
+        const std::unordered_map<Tag, TagHandler> handlers = {
+            {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
+            {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
+        };
+        parseDumpBody(body, handlers);
+        return;
+    }
+
+    for (const auto& segment : body.directory->heapDumpSegments) {
+        // everything before the first handled sub-record would only be skipped
+        uint32_t begin = HeapDumpSegmentLocation::NONE;
+        for (const auto& [subTag, handler] : subTagHandlers) {
+            begin = std::min(begin, segment.firstSubRecordOffsets[subTagIndex(subTag)]);
+        }
+        if (begin == HeapDumpSegmentLocation::NONE) {
+            continue;
+        }
+        const auto& location = segment.location;
+        R           hdsr     = body.reader.at(location.offset + begin, location.bodyByteSize - begin);
+        parseHeapDumpSegment(hdsr, identifierSize, subTagHandlers);
+    }
+}
+
+ClassDumpTable parseClassDumps(DumpBody body, size_t identifierSize) {
+    ClassDumpTable classDumps;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::CLASS_DUMP>, R& r) {
+        auto       cd = parseClassDump(r, identifierSize, classDumps.get_allocator());
+        const auto id = cd.classObjectID;
+        classDumps.insert({id, std::move(cd)});
+    });
     return classDumps;
 }
 
-std::unordered_map<ClassObjectID, size_t> countInstances(R reader, size_t identifierSize) {
-    std::unordered_map<ClassObjectID, size_t>       counts;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::INSTANCE_DUMP,
-         [&](R& r) {
-             r.skip(identifierSize + 4);
-             const auto classObjectID = r.read<ClassObjectID>(identifierSize);
-             ++counts[classObjectID];
-             const auto fieldsSizeBytes = r.read<uint32_t>();
-             r.skip(fieldsSizeBytes);
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+InstanceCountTable countInstances(DumpBody body, size_t identifierSize) {
+    InstanceCountTable counts;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::INSTANCE_DUMP>, R& r) {
+        UncheckedR head = r.validated(instanceDumpHeadSize(identifierSize));
+        head.skip(identifierSize + 4);
+        const auto classObjectID = head.read<ClassObjectID>(identifierSize);
+        ++counts[classObjectID];
+        const auto fieldsSizeBytes = head.read<uint32_t>();
+        r.skip(fieldsSizeBytes);
+    });
     return counts;
 }
 
-InstanceDump parseInstanceDump(R& r, size_t identifierSize) {
+template <typename IDSize>
+InstanceDump parseInstanceDump(R& r, IDSize identifierSize) {
     InstanceDump i;
-    r.read(i.objectID, identifierSize);
-    r.read(i.stackTraceSerialNumber);
-    r.read(i.classObjectID, identifierSize);
-    const auto fieldsSizeBytes = r.read<uint32_t>();
+    UncheckedR   head = r.validated(instanceDumpHeadSize(identifierSize));
+    head.read(i.objectID, identifierSize);
+    head.read(i.stackTraceSerialNumber);
+    head.read(i.classObjectID, identifierSize);
+    const auto fieldsSizeBytes = head.read<uint32_t>();
     i.fieldsView               = r.skip(fieldsSizeBytes);
     return i;
 }
 
-std::unordered_map<ObjectID, const std::byte*> parseAllInstanceLocations(R reader, size_t identifierSize) {
-    std::unordered_map<ObjectID, const std::byte*>  locations;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::INSTANCE_DUMP,
-         [&, identifierSize](R& r) {
-             const std::byte* location = r.it();
-             const ObjectID   objectID = r.read<ObjectID>(identifierSize);
-             locations.insert({objectID, location});
-             r.skip(4 + identifierSize);
-             const auto fieldsSizeBytes = r.read<uint32_t>();
-             r.skip(fieldsSizeBytes);
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+std::unordered_map<ObjectID, const std::byte*> parseAllInstanceLocations(DumpBody body, size_t identifierSize) {
+    std::unordered_map<ObjectID, const std::byte*> locations;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::INSTANCE_DUMP>, R& r) {
+        const std::byte* location = r.it();
+        UncheckedR       head     = r.validated(instanceDumpHeadSize(identifierSize));
+        const ObjectID   objectID = head.read<ObjectID>(identifierSize);
+        locations.insert({objectID, location});
+        head.skip(4 + identifierSize);
+        const auto fieldsSizeBytes = head.read<uint32_t>();
+        r.skip(fieldsSizeBytes);
+    });
     return locations;
 }
 
-std::unordered_map<ObjectID, InstanceDump> parseClassInstances(R reader, size_t identifierSize, ClassObjectID target) {
-    std::unordered_map<ObjectID, InstanceDump>      instances;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::INSTANCE_DUMP,
-         [&, identifierSize, target](R& r) {
-             const auto instance = parseInstanceDump(r, identifierSize);
-             if (instance.classObjectID == target) {
-                 auto const objectID = instance.objectID;
-                 instances.insert({objectID, std::move(instance)});
-             }
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+std::unordered_map<ObjectID, InstanceDump> parseClassInstances(DumpBody body, size_t identifierSize, ClassObjectID target) {
+    std::unordered_map<ObjectID, InstanceDump> instances;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::INSTANCE_DUMP>, R& r) {
+        const auto instance = parseInstanceDump(r, identifierSize);
+        if (instance.classObjectID == target) {
+            auto const objectID = instance.objectID;
+            instances.insert({objectID, std::move(instance)});
+        }
+    });
     return instances;
 }
 
-std::unordered_map<StackFrameID, StackFrame> parseStackFrames(R reader, size_t identifierSize) {
-    std::unordered_map<StackFrameID, StackFrame> frames;
-    std::unordered_map<Tag, TagHandler>          tagHandlers = {
-        {Tag::STACK_FRAME,
-         [&, identifierSize](R& r, const RecordHeader&) {
-             StackFrame frame;
-             r.read(frame.stackFrameID, identifierSize);
-             r.read(frame.methodNameStringID, identifierSize);
-             r.read(frame.methodSignatureStringID, identifierSize);
-             r.read(frame.sourceFileNameStringID, identifierSize);
-             r.read(frame.classSerialNumber);
-             r.read(frame.lineNumber);
-             frames.insert({frame.stackFrameID, frame});
-         }},
-    };
-    parseDumpBody(reader, tagHandlers);
+StackFrame parseStackFrame(R& r, size_t identifierSize) {
+    StackFrame frame;
+    r.read(frame.stackFrameID, identifierSize);
+    r.read(frame.methodNameStringID, identifierSize);
+    r.read(frame.methodSignatureStringID, identifierSize);
+    r.read(frame.sourceFileNameStringID, identifierSize);
+    r.read(frame.classSerialNumber);
+    r.read(frame.lineNumber);
+    return frame;
+}
+
+StackFrameTable parseStackFrames(DumpBody body, size_t identifierSize) {
+    StackFrameTable frames;
+    visitDumpBody(body, [&](TagConstant<Tag::STACK_FRAME>, R& r, const RecordHeader&) {
+        const auto frame = parseStackFrame(r, identifierSize);
+        frames.insert({frame.stackFrameID, frame});
+    });
     return frames;
 }
 
-std::unordered_map<StackTraceSerialNumber, StackTrace> parseStackTraces(R reader, size_t identifierSize) {
-    std::unordered_map<StackTraceSerialNumber, StackTrace> traces;
-    std::unordered_map<Tag, TagHandler>                    tagHandlers = {
-        {Tag::STACK_TRACE,
-         [&, identifierSize](R& r, const RecordHeader&) {
-             StackTrace trace;
-             r.read(trace.stackTraceSerialNumber);
-             r.read(trace.threadSerialNumber);
-             r.read(trace.numberOfFrames);
-             for (int64_t i = 0; i < trace.numberOfFrames; ++i) {
-                 trace.stackFrames.push_back(r.read<StackFrameID>(identifierSize));
-             }
-             const auto serialNumber = trace.stackTraceSerialNumber;
-             traces.insert({serialNumber, std::move(trace)});
-         }},
-    };
-    parseDumpBody(reader, tagHandlers);
+StackTrace parseStackTrace(R& r, size_t identifierSize, const StackTrace::allocator_type& allocator) {
+    StackTrace trace(allocator);
+    r.read(trace.stackTraceSerialNumber);
+    r.read(trace.threadSerialNumber);
+    r.read(trace.numberOfFrames);
+    for (int64_t i = 0; i < trace.numberOfFrames; ++i) {
+        trace.stackFrames.push_back(r.read<StackFrameID>(identifierSize));
+    }
+    return trace;
+}
+
+StackTraceTable parseStackTraces(DumpBody body, size_t identifierSize) {
+    StackTraceTable traces;
+    visitDumpBody(body, [&](TagConstant<Tag::STACK_TRACE>, R& r, const RecordHeader&) {
+        auto       trace        = parseStackTrace(r, identifierSize, traces.get_allocator());
+        const auto serialNumber = trace.stackTraceSerialNumber;
+        traces.insert({serialNumber, std::move(trace)});
+    });
     return traces;
 }
 
-std::unordered_map<ArrayObjectID, ObjectArrayDump> parseObjectArrayDumps(R reader, size_t identifierSize) {
+template <typename IDSize>
+ObjectArrayDump parseObjectArrayDump(R& r, IDSize identifierSize) {
+    ObjectArrayDump array;
+    UncheckedR      head = r.validated(objectArrayDumpHeadSize(identifierSize));
+    head.read(array.arrayObjectID, identifierSize);
+    head.read(array.stackTraceSerialNumber);
+    head.read(array.numberOfElements);
+    head.read(array.arrayClassObjectID, identifierSize);
+    array.elementsView = r.skip(identifierSize * array.numberOfElements);
+    return array;
+}
+
+std::unordered_map<ArrayObjectID, ObjectArrayDump> parseObjectArrayDumps(DumpBody body, size_t identifierSize) {
     std::unordered_map<ArrayObjectID, ObjectArrayDump> objectArrays;
-    const std::unordered_map<SubTag, SubTagHandler>    subTagHandlers = {
-        {SubTag::OBJECT_ARRAY_DUMP,
-         [&, identifierSize](R& r) {
-             ObjectArrayDump array;
-             r.read(array.arrayObjectID, identifierSize);
-             r.read(array.stackTraceSerialNumber);
-             r.read(array.numberOfElements);
-             r.read(array.arrayClassObjectID);
-             array.elementsView = r.skip(identifierSize * array.numberOfElements);
-             const auto id      = array.arrayObjectID;
-             objectArrays.insert({id, std::move(array)});
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::OBJECT_ARRAY_DUMP>, R& r) {
+        auto       array = parseObjectArrayDump(r, identifierSize);
+        const auto id    = array.arrayObjectID;
+        objectArrays.insert({id, std::move(array)});
+    });
     return objectArrays;
 }
 
-std::unordered_map<ArrayObjectID, PrimitiveArrayDump> parsePrimitiveArrayDumps(R reader, size_t identifierSize) {
+template <typename IDSize>
+PrimitiveArrayDump parsePrimitiveArrayDump(R& r, IDSize identifierSize) {
+    PrimitiveArrayDump array;
+    UncheckedR         head = r.validated(primitiveArrayDumpHeadSize(identifierSize));
+    head.read(array.arrayObjectID, identifierSize);
+    head.read(array.stackTraceSerialNumber);
+    head.read(array.numberOfElements);
+    array.elementType  = validateBasicType(head.read<uint8_t>());
+    array.elementsView = r.skip(basicTypeSize(array.elementType, identifierSize) * array.numberOfElements);
+    return array;
+}
+
+std::unordered_map<ArrayObjectID, PrimitiveArrayDump> parsePrimitiveArrayDumps(DumpBody body, size_t identifierSize) {
     std::unordered_map<ArrayObjectID, PrimitiveArrayDump> primitiveArrays;
-    const std::unordered_map<SubTag, SubTagHandler>       subTagHandlers = {
-        {SubTag::PRIMITIVE_ARRAY_DUMP,
-         [&, identifierSize](R& r) {
-             PrimitiveArrayDump array;
-             r.read(array.arrayObjectID, identifierSize);
-             r.read(array.stackTraceSerialNumber);
-             r.read(array.numberOfElements);
-             array.elementType  = validateBasicType(r.read<uint8_t>());
-             array.elementsView = r.skip(basicTypeSize(array.elementType) * array.numberOfElements);
-             const auto id      = array.arrayObjectID;
-             primitiveArrays.insert({id, std::move(array)});
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::PRIMITIVE_ARRAY_DUMP>, R& r) {
+        auto       array = parsePrimitiveArrayDump(r, identifierSize);
+        const auto id    = array.arrayObjectID;
+        primitiveArrays.insert({id, std::move(array)});
+    });
     return primitiveArrays;
 }
 
-std::unordered_map<ObjectID, InstanceDump> parseInstanceDumps(R reader, size_t identifierSize) {
-    std::unordered_map<ObjectID, InstanceDump>      instances;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::INSTANCE_DUMP,
-         [&, identifierSize](R& r) {
-             const auto instance = parseInstanceDump(r, identifierSize);
-             const auto objectID = instance.objectID;
-             instances.insert({objectID, std::move(instance)});
-         }},
-    };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
-    };
-    parseDumpBody(reader, handlers);
+std::unordered_map<ObjectID, InstanceDump> parseInstanceDumps(DumpBody body, size_t identifierSize) {
+    std::unordered_map<ObjectID, InstanceDump> instances;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::INSTANCE_DUMP>, R& r) {
+        const auto instance = parseInstanceDump(r, identifierSize);
+        const auto objectID = instance.objectID;
+        instances.insert({objectID, std::move(instance)});
+    });
     return instances;
 }
 
-std::unordered_map<ObjectID, RootThread> parseRootThreads(R reader, size_t identifierSize) {
-    std::unordered_map<ObjectID, RootThread>        rootThreads;
-    const std::unordered_map<SubTag, SubTagHandler> subTagHandlers = {
-        {SubTag::ROOT_THREAD_OBJECT,
-         [&, identifierSize](R& r) {
-             RootThread rootThread;
-             r.read(rootThread.threadObjectID, identifierSize);
-             r.read(rootThread.threadSerialNumber);
-             r.read(rootThread.stackTraceSerialNumber);
-             const auto objectID = rootThread.threadObjectID;
-             rootThreads.insert({objectID, std::move(rootThread)});
-         }},
+RootThread parseRootThread(R& r, size_t identifierSize) {
+    RootThread rootThread;
+    r.read(rootThread.threadObjectID, identifierSize);
+    r.read(rootThread.threadSerialNumber);
+    r.read(rootThread.stackTraceSerialNumber);
+    return rootThread;
+}
+
+template <typename IDSize>
+void parseGCRoot(R& reader, SubTag subTag, IDSize identifierSize, GCRootTable::Builder& roots) {
+    const size_t bodySize = subTagSize(subTag, identifierSize);
+    if (bodySize == DYNAMIC) {
+        throw std::runtime_error(std::format("{} is not a GC root", subTagName(subTag)));
+    }
+    UncheckedR r  = reader.validated(bodySize);
+    const auto id = r.read<ID>(identifierSize);
+    switch (subTag) {
+        using enum SubTag;
+    case ROOT_UNKNOWN:
+    case ROOT_STICKY_CLASS:
+    case ROOT_MONITOR_USED: {
+        roots.add(id, subTag);
+        return;
+    }
+    case ROOT_JNI_GLOBAL: {
+        r.skip(identifierSize); // JNI global ref ID
+        roots.add(id, subTag);
+        return;
+    }
+    case ROOT_JNI_LOCAL:
+    case ROOT_JAVA_FRAME: {
+        const auto threadSerialNumber = r.read<uint32_t>();
+        const auto frameNumber        = r.read<uint32_t>();
+        roots.add(id, subTag, threadSerialNumber, frameNumber);
+        return;
+    }
+    case ROOT_NATIVE_STACK:
+    case ROOT_THREAD_BLOCK: {
+        roots.add(id, subTag, r.read<uint32_t>());
+        return;
+    }
+    case ROOT_THREAD_OBJECT: {
+        const auto threadSerialNumber = r.read<uint32_t>();
+        r.skip(4); // stack trace serial number
+        roots.add(id, subTag, threadSerialNumber);
+        return;
+    }
+    case CLASS_DUMP:
+    case INSTANCE_DUMP:
+    case OBJECT_ARRAY_DUMP:
+    case PRIMITIVE_ARRAY_DUMP: break;
+    }
+    throw std::runtime_error(std::format("{} is not a GC root", subTagName(subTag)));
+}
+
+std::unordered_map<ObjectID, RootThread> parseRootThreads(DumpBody body, size_t identifierSize) {
+    std::unordered_map<ObjectID, RootThread> rootThreads;
+    visitHeapDump(body, identifierSize, [&](SubTagConstant<SubTag::ROOT_THREAD_OBJECT>, R& r) {
+        auto       rootThread = parseRootThread(r, identifierSize);
+        const auto objectID   = rootThread.threadObjectID;
+        rootThreads.insert({objectID, std::move(rootThread)});
+    });
+    return rootThreads;
+}
+
+namespace {
+
+HeapDumpSegmentLocation newHeapDumpSegmentLocation(const RecordLocation& location) {
+    HeapDumpSegmentLocation segment;
+    segment.location = location;
+    segment.firstSubRecordOffsets.fill(HeapDumpSegmentLocation::NONE);
+    return segment;
+}
+
+void recordSubRecordOffset(HeapDumpSegmentLocation& segment, SubTag subTag, size_t offset) {
+    auto& first = segment.firstSubRecordOffsets[subTagIndex(subTag)];
+    if (first == HeapDumpSegmentLocation::NONE) {
+        first = static_cast<uint32_t>(offset);
+    }
+}
+
+// heap tables filled by one worker, merged into ParsedDump afterwards;
+// each worker allocates from an arena of its own, as monotonic resources are not thread-safe
+struct HeapTables {
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena =
+        std::make_unique<std::pmr::monotonic_buffer_resource>();
+    std::map<SubTag, size_t>                             subTagCounts;
+    size_t                                               numSubtags = 0;
+    ClassDumpTable                                       classDumps{arena.get()};
+    InstanceCountTable                                   classInstanceCount{arena.get()};
+};
+
+// tables filled per chunk rather than per thread, so that they keep dump order
+struct HeapChunkTables {
+    std::vector<ObjectDirectory::Entry> objects;
+    GCRootTable::Builder                gcRoots;
+};
+
+// segments larger than this are split into chunks of about this size to be decoded in parallel
+static constexpr size_t HEAP_CHUNK_BYTES = 64 * 1024 * 1024;
+
+// smallest chunk a memory budget cuts segments into
+static constexpr size_t MIN_HEAP_CHUNK_BYTES = 256 * 1024;
+
+// how far ahead a walk over a segment of an inflated dump fetches it: a sub-record header,
+// or a whole class dump, which its 16-bit counts keep below this
+static constexpr size_t SUB_RECORD_LOOKAHEAD = 4 * 1024 * 1024;
+
+// [begin, end) range of whole sub-records of a heap dump segment
+struct HeapChunk {
+    size_t   segment;
+    uint32_t begin;
+    uint32_t end;
+    bool     locateSubRecords; // whether decoding it also fills firstSubRecordOffsets of the segment
+};
+
+// boundary-only walk over a segment body, which only decodes sub-record lengths;
+// fills firstSubRecordOffsets on the way, since chunks decoded in parallel can't;
+// with windows, the sub-records are fetched ahead of the walk, base being the offset of r in the dump
+template <typename IDSize>
+void splitHeapDumpSegment(R                        r,
+                          size_t                   base,
+                          IDSize                   identifierSize,
+                          GzipWindowCache*         windows,
+                          size_t                   segmentIndex,
+                          HeapDumpSegmentLocation& segment,
+                          size_t                   chunkBytes,
+                          std::vector<HeapChunk>&  chunks) {
+    GzipWindowCache::Pin pin;
+    size_t               chunkBegin = 0;
+    while (!r.eof()) {
+        const size_t subRecordOffset = r.offset();
+        if (windows != nullptr) {
+            const size_t ahead = std::min(r.size() - subRecordOffset, SUB_RECORD_LOOKAHEAD);
+            if (base + subRecordOffset + ahead > pin.end()) {
+                pin = windows->fetch(base + subRecordOffset, ahead);
+                if (pin.end() < base + subRecordOffset + ahead) {
+                    throw std::runtime_error("out of bounds read");
+                }
+            }
+        }
+        if (subRecordOffset - chunkBegin >= chunkBytes) {
+            chunks.push_back(
+                {segmentIndex, static_cast<uint32_t>(chunkBegin), static_cast<uint32_t>(subRecordOffset), false});
+            chunkBegin = subRecordOffset;
+        }
+        const SubTag subTag = validateSubTag(r.read<uint8_t>());
+        recordSubRecordOffset(segment, subTag, subRecordOffset);
+        skipSubRecord(r, subTag, identifierSize);
+    }
+    chunks.push_back({segmentIndex, static_cast<uint32_t>(chunkBegin), static_cast<uint32_t>(r.offset()), false});
+}
+
+// base is the offset of r from the beginning of the dump reader
+template <typename IDSize>
+void indexHeapDumpSegment(R&                                   r,
+                          size_t                               base,
+                          IDSize                               identifierSize,
+                          HeapTables&                          tables,
+                          HeapChunkTables&                     chunkTables,
+                          HeapDumpSegmentLocation*             segment) {
+    auto& objects = chunkTables.objects;
+    while (!r.eof()) {
+        const size_t subRecordOffset = r.offset();
+        const SubTag subTag          = validateSubTag(r.read<uint8_t>());
+        if (segment != nullptr) {
+            recordSubRecordOffset(*segment, subTag, subRecordOffset);
+        }
+
+        ++tables.subTagCounts[subTag];
+        ++tables.numSubtags;
+
+        const size_t bodyOffset = base + r.offset();
+        switch (subTag) {
+            using enum SubTag;
+        case CLASS_DUMP: {
+            auto       cd = parseClassDump(r, identifierSize, tables.classDumps.get_allocator());
+            const auto id = cd.classObjectID;
+            objects.push_back(ObjectDirectory::makeEntry(static_cast<ID>(id), ObjectKind::CLASS, bodyOffset));
+            tables.classDumps.insert({id, std::move(cd)});
+            break;
+        }
+        case INSTANCE_DUMP: {
+            const auto instance = parseInstanceDump(r, identifierSize);
+            ++tables.classInstanceCount[instance.classObjectID];
+            objects.push_back(
+                ObjectDirectory::makeEntry(static_cast<ID>(instance.objectID), ObjectKind::INSTANCE, bodyOffset));
+            break;
+        }
+        case OBJECT_ARRAY_DUMP: {
+            const auto array = parseObjectArrayDump(r, identifierSize);
+            objects.push_back(
+                ObjectDirectory::makeEntry(static_cast<ID>(array.arrayObjectID), ObjectKind::OBJECT_ARRAY, bodyOffset));
+            break;
+        }
+        case PRIMITIVE_ARRAY_DUMP: {
+            const auto array = parsePrimitiveArrayDump(r, identifierSize);
+            objects.push_back(ObjectDirectory::makeEntry(
+                static_cast<ID>(array.arrayObjectID), ObjectKind::PRIMITIVE_ARRAY, bodyOffset));
+            break;
+        }
+        default: parseGCRoot(r, subTag, identifierSize, chunkTables.gcRoots);
+        }
+    }
+}
+
+// class dumps are copied into the tables of the dump, as they live in the arena of the worker;
+// the first dump of a class wins, as with insert
+void mergeHeapTables(ParsedDump& dump, HeapTables& tables) {
+    for (const auto& [subTag, count] : tables.subTagCounts) {
+        dump.summary.subTagCounts[subTag] += count;
+    }
+    dump.summary.numSubtags += tables.numSubtags;
+    for (const auto& [classObjectID, count] : tables.classInstanceCount) {
+        dump.classInstanceCount[classObjectID] += count;
+    }
+    dump.classDumps.reserve(dump.classDumps.size() + tables.classDumps.size());
+    for (auto& [classObjectID, classDump] : tables.classDumps) {
+        dump.classDumps.try_emplace(classObjectID, std::move(classDump));
+    }
+}
+
+} // namespace
+
+ParsedDump parseDump(R                                  r,
+                     size_t                             identifierSize,
+                     size_t                             threads,
+                     const std::optional<SpillOptions>& spill,
+                     std::pmr::memory_resource*         tableResource,
+                     GzipWindowCache*                   windows) {
+    ParsedDump dump(tableResource);
+
+    // when spilling, chunks also bound how many objects are held in memory at once:
+    // half of the budget goes to sorting, the other half to a batch of chunks decoded together,
+    // whose objects and roots take up to about twice the bytes of the chunk while handed over;
+    // a batch of an inflated dump also has to fit into the window cache next to the windows being walked
+    size_t chunkBytes = HEAP_CHUNK_BYTES;
+    size_t batchSize  = std::max<size_t>(1, threads);
+    if (spill.has_value()) {
+        const size_t budget = spill->memoryBudgetBytes / 4;
+        batchSize           = std::clamp<size_t>(budget / MIN_HEAP_CHUNK_BYTES, 1, batchSize);
+        chunkBytes          = std::clamp<size_t>(budget / batchSize, MIN_HEAP_CHUNK_BYTES, HEAP_CHUNK_BYTES);
+    }
+    if (windows != nullptr) {
+        chunkBytes = std::clamp<size_t>(windows->capacityBytes() / 2 / batchSize, MIN_HEAP_CHUNK_BYTES, chunkBytes);
+    }
+
+    // a single huge HEAP_DUMP record would leave all but one thread idle,
+    // so large segments are cut at sub-record boundaries first;
+    // segments of an inflated dump are always walked, as that fetches them ahead of decoding
+    auto&                  segments = dump.directory.heapDumpSegments;
+    std::vector<HeapChunk> chunks;
+    const auto             addChunks = [&](size_t i) {
+        const auto& location = segments[i].location;
+        if (windows != nullptr || ((threads > 1 || spill.has_value()) && location.bodyByteSize > chunkBytes)) {
+            withIdentifierSize(identifierSize, [&](auto idSize) {
+                splitHeapDumpSegment(r.at(location.offset, location.bodyByteSize),
+                                     location.offset,
+                                     idSize,
+                                     windows,
+                                     i,
+                                     segments[i],
+                                     chunkBytes,
+                                     chunks);
+            });
+        } else {
+            chunks.push_back({i, 0, location.bodyByteSize, true});
+        }
     };
-    const auto heapDumpSegmentTagHandler               = createHeapDumpSegmentHandler(identifierSize, subTagHandlers);
-    const std::unordered_map<Tag, TagHandler> handlers = {
-        {        Tag::HEAP_DUMP, heapDumpSegmentTagHandler},
-        {Tag::HEAP_DUMP_SEGMENT, heapDumpSegmentTagHandler},
+
+    // objects are collected per chunk, so that they are numbered in dump order
+    std::vector<HeapTables>                          perThreadTables(std::max<size_t>(1, threads));
+    std::vector<HeapChunkTables>                     perChunkTables;
+    std::vector<std::vector<ObjectDirectory::Entry>> perChunkObjects;
+    GCRootTable::Builder                             gcRoots;
+    std::optional<ObjectDirectory::SpillBuilder>     spilledObjects;
+    std::optional<GCRootTable::SpillBuilder>         spilledGCRoots;
+    if (spill.has_value()) {
+        spilledObjects.emplace(spill->pathPrefix, spill->memoryBudgetBytes / 2);
+        spilledGCRoots.emplace(spill->pathPrefix);
+    }
+    // decodes the chunks from `decoded` to `end` and hands their objects and roots over in dump order;
+    // when spilling, a batch of chunks at a time is handed over to the builders and dropped
+    size_t     decoded      = 0;
+    const auto decodeChunks = [&](size_t end) {
+        GzipWindowCache::Pin pin;
+        if (windows != nullptr) {
+            const size_t begin = segments[chunks[decoded].segment].location.offset + chunks[decoded].begin;
+            const size_t last  = segments[chunks[end - 1].segment].location.offset + chunks[end - 1].end;
+            pin                = windows->fetch(begin, last - begin);
+        }
+        perChunkTables.resize(end - decoded);
+        parallelFor(end - decoded, threads, [&](size_t i, size_t thread) {
+            const auto&  chunk   = chunks[decoded + i];
+            auto&        segment = segments[chunk.segment];
+            const size_t base    = segment.location.offset + chunk.begin;
+            R            hdsr    = r.at(base, chunk.end - chunk.begin);
+            withIdentifierSize(identifierSize, [&](auto idSize) {
+                indexHeapDumpSegment(hdsr,
+                                     base,
+                                     idSize,
+                                     perThreadTables[thread],
+                                     perChunkTables[i],
+                                     chunk.locateSubRecords ? &segment : nullptr);
+            });
+        });
+        for (auto& chunkTables : perChunkTables) {
+            if (spill.has_value()) {
+                spilledObjects->add(chunkTables.objects);
+                spilledGCRoots->append(chunkTables.gcRoots);
+            } else {
+                perChunkObjects.push_back(std::move(chunkTables.objects));
+                gcRoots.append(chunkTables.gcRoots);
+            }
+            chunkTables = {};
+        }
+        decoded = end;
     };
-    parseDumpBody(reader, handlers);
-    return rootThreads;
+    const bool batched = spill.has_value() || windows != nullptr;
+
+    // top-level records are cheap and decoded right away, heap dump segments are cut into chunks decoded
+    // in parallel: in batches as they come when spilling or inflating, otherwise all at once after the scan;
+    // an inflated dump is fetched record by record, and its end is only known once the stream gets there
+    GzipWindowCache::Pin pin;
+    while (windows != nullptr || !r.eof()) {
+        if (windows != nullptr) {
+            pin = windows->fetch(r.offset(), RECORD_HEADER_SIZE);
+            if (pin.end() == r.offset()) {
+                break;
+            }
+            if (pin.end() - r.offset() < RECORD_HEADER_SIZE) {
+                throw std::runtime_error("out of bounds read");
+            }
+        }
+        const auto           recordHeader = parseRecordHeader(r);
+        const RecordLocation location{r.offset(), recordHeader.micros, recordHeader.bodyByteSize};
+        dump.directory.records[recordHeader.tag].push_back(location);
+        const bool heapDumpSegment =
+            recordHeader.tag == Tag::HEAP_DUMP || recordHeader.tag == Tag::HEAP_DUMP_SEGMENT;
+        if (windows != nullptr && !heapDumpSegment) {
+            pin = windows->fetch(location.offset, location.bodyByteSize);
+        }
+        R br = (windows != nullptr && !heapDumpSegment ? R(windows->data(), pin.end()) : r)
+                   .at(location.offset, location.bodyByteSize);
+        switch (recordHeader.tag) {
+            using enum Tag;
+        case STRING_IN_UTF8: {
+            auto s = parseStringInUTF8(br, recordHeader, identifierSize);
+            if (windows != nullptr) {
+                // windows don't stay in memory, so strings are copied out of them
+                auto* copy = static_cast<char*>(tableResource->allocate(s.view.size(), 1));
+                std::copy(s.view.begin(), s.view.end(), copy);
+                s.view = {copy, s.view.size()};
+            }
+            dump.strings.insert({s.id, s});
+            break;
+        }
+        case LOAD_CLASS: {
+            const auto c = parseLoadClass(br, identifierSize);
+            dump.loadClasses.insert({c.classObjectID, c});
+            break;
+        }
+        case STACK_FRAME: {
+            const auto frame = parseStackFrame(br, identifierSize);
+            dump.stackFrames.insert({frame.stackFrameID, frame});
+            break;
+        }
+        case STACK_TRACE: {
+            auto       trace        = parseStackTrace(br, identifierSize, dump.stackTraces.get_allocator());
+            const auto serialNumber = trace.stackTraceSerialNumber;
+            dump.stackTraces.insert({serialNumber, std::move(trace)});
+            break;
+        }
+        case HEAP_DUMP:
+        case HEAP_DUMP_SEGMENT: {
+            segments.push_back(newHeapDumpSegmentLocation(location));
+            addChunks(segments.size() - 1);
+            while (batched && chunks.size() - decoded >= batchSize) {
+                decodeChunks(decoded + batchSize);
+            }
+            break;
+        }
+        default: break;
+        }
+        r.skip(recordHeader.bodyByteSize);
+
+        ++dump.summary.tagCounts[recordHeader.tag];
+        ++dump.summary.numRecords;
+    }
+    pin.release();
+
+    while (decoded < chunks.size()) {
+        decodeChunks(batched ? std::min(chunks.size(), decoded + batchSize) : chunks.size());
+    }
+    if (spill.has_value()) {
+        dump.objects = spilledObjects->finish(dump.spillFiles);
+        dump.gcRoots = spilledGCRoots->finish(dump.spillFiles);
+    } else {
+        dump.objects = ObjectDirectory(perChunkObjects);
+        dump.gcRoots = GCRootTable(std::move(gcRoots));
+    }
+    for (auto& tables : perThreadTables) {
+        mergeHeapTables(dump, tables);
+    }
+
+    return dump;
+}
+
+R objectDumpReader(R                     dump,
+                   ObjectLocation        location,
+                   size_t                identifierSize,
+                   GzipWindowCache*      windows,
+                   GzipWindowCache::Pin& pin) {
+    if (windows == nullptr) {
+        return dump.at(location.offset, dump.size() - location.offset);
+    }
+
+    // the head of the sub-record is fetched first, which tells how long it is and mostly brings all of it along;
+    // a class dump is only as long as its lists, so all it can take up is fetched and it is read through
+    size_t headSize = SUB_RECORD_LOOKAHEAD;
+    switch (location.kind) {
+        using enum ObjectKind;
+    case INSTANCE:        headSize = instanceDumpHeadSize(identifierSize); break;
+    case OBJECT_ARRAY:    headSize = objectArrayDumpHeadSize(identifierSize); break;
+    case PRIMITIVE_ARRAY: headSize = primitiveArrayDumpHeadSize(identifierSize); break;
+    case CLASS:           break;
+    case NONE:            throw std::runtime_error("no object at this location");
+    }
+    pin = windows->fetch(location.offset, headSize);
+    R head = R(windows->data(), pin.end()).at(location.offset, pin.end() - location.offset);
+
+    size_t size = headSize;
+    switch (location.kind) {
+        using enum ObjectKind;
+    case INSTANCE: {
+        head.skip(2 * identifierSize + sizeof(uint32_t));
+        size += head.read<uint32_t>();
+        break;
+    }
+    case OBJECT_ARRAY: {
+        head.skip(identifierSize + sizeof(uint32_t));
+        size += size_t{head.read<uint32_t>()} * identifierSize;
+        break;
+    }
+    case PRIMITIVE_ARRAY: {
+        head.skip(identifierSize + sizeof(uint32_t));
+        const size_t numberOfElements = head.read<uint32_t>();
+        const auto   elementType      = static_cast<BasicType>(head.read<uint8_t>());
+        size += numberOfElements * basicTypeSize(elementType, identifierSize);
+        break;
+    }
+    case CLASS: {
+        skipClassDump(head, identifierSize);
+        size = head.offset();
+        break;
+    }
+    case NONE: break;
+    }
+
+    if (pin.end() - location.offset < size) {
+        pin = windows->fetch(location.offset, size);
+    }
+    return R(windows->data(), pin.end()).at(location.offset, size);
+}
+
+RecordDirectory buildRecordDirectory(R r, size_t identifierSize) {
+    RecordDirectory directory;
+    while (!r.eof()) {
+        const auto           recordHeader = parseRecordHeader(r);
+        const RecordLocation location{r.offset(), recordHeader.micros, recordHeader.bodyByteSize};
+        directory.records[recordHeader.tag].push_back(location);
+        if (recordHeader.tag == Tag::HEAP_DUMP || recordHeader.tag == Tag::HEAP_DUMP_SEGMENT) {
+            auto segment = newHeapDumpSegmentLocation(location);
+            R    hdsr    = r.at(location.offset, location.bodyByteSize);
+            withIdentifierSize(identifierSize, [&](auto idSize) {
+                while (!hdsr.eof()) {
+                    const size_t subRecordOffset = hdsr.offset();
+                    const SubTag subTag          = validateSubTag(hdsr.read<uint8_t>());
+                    recordSubRecordOffset(segment, subTag, subRecordOffset);
+                    skipSubRecord(hdsr, subTag, idSize);
+                }
+            });
+            directory.heapDumpSegments.push_back(segment);
+        }
+        r.skip(recordHeader.bodyByteSize);
+    }
+    return directory;
 }
+
+// the decoders are instantiated for every identifier size withIdentifierSize can pass
+#define INSTANTIATE_SUB_RECORD_DECODERS(IDSize)                                               \
+    template void               skipClassDump(R&, IDSize);                                    \
+    template void               skipInstanceDump(R&, IDSize);                                 \
+    template void               skipObjectArrayDump(R&, IDSize);                              \
+    template void               skipPrimitiveArrayDump(R&, IDSize);                           \
+    template void               skipSubRecord(R&, SubTag, IDSize);                            \
+    template ClassDump          parseClassDump(R&, IDSize, const ClassDump::allocator_type&); \
+    template InstanceDump       parseInstanceDump(R&, IDSize);                                \
+    template ObjectArrayDump    parseObjectArrayDump(R&, IDSize);                             \
+    template PrimitiveArrayDump parsePrimitiveArrayDump(R&, IDSize);                          \
+    template void               parseGCRoot(R&, SubTag, IDSize, GCRootTable::Builder&);
+
+INSTANTIATE_SUB_RECORD_DECODERS(size_t)
+INSTANTIATE_SUB_RECORD_DECODERS(IdentifierSize<4>)
+INSTANTIATE_SUB_RECORD_DECODERS(IdentifierSize<8>)
+
+#undef INSTANTIATE_SUB_RECORD_DECODERS
@@ -1,12 +1,23 @@
 #pragma once
 
 #include <data/data.h>
+#include <index/gc_roots.h>
+#include <index/object_directory.h>
+#include <utils/fs_utils.h>
+#include <utils/gzip.h>
 #include <utils/reader.h>
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <functional>
+#include <limits>
 #include <map>
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 using TagHandler    = std::function<void(R&, const RecordHeader&)>;
 using SubTagHandler = std::function<void(R&)>;
@@ -18,45 +29,158 @@ struct DumpSummary {
     std::map<SubTag, size_t> subTagCounts;
 };
 
+struct RecordLocation {
+    size_t   offset; // of the record body, from the beginning of the reader
+    uint32_t micros;
+    uint32_t bodyByteSize;
+};
+
+struct HeapDumpSegmentLocation {
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    RecordLocation location;
+    // offset of the first sub-record of each kind (by subTagIndex) relative to the segment body, or NONE
+    std::array<uint32_t, NUM_SUB_TAGS> firstSubRecordOffsets;
+};
+
+// where every record of a dump is, so that parsers can jump straight to the records they need
+struct RecordDirectory {
+    std::map<Tag, std::vector<RecordLocation>> records;
+    std::vector<HeapDumpSegmentLocation>       heapDumpSegments; // both HEAP_DUMP and HEAP_DUMP_SEGMENT
+};
+
+// dump body to parse, optionally with its directory
+struct DumpBody {
+    DumpBody(R r)
+      : reader(r) {}
+
+    DumpBody(R r, const RecordDirectory& recordDirectory)
+      : reader(r)
+      , directory(&recordDirectory) {}
+
+    R                      reader;
+    const RecordDirectory* directory = nullptr;
+};
+
+// all tables of a dump, filled in a single scan by parseDump
+struct ParsedDump {
+    // the record tables are allocated from `resource`
+    explicit ParsedDump(std::pmr::memory_resource* resource)
+      : strings(resource)
+      , loadClasses(resource)
+      , classDumps(resource)
+      , classInstanceCount(resource)
+      , stackFrames(resource)
+      , stackTraces(resource) {}
+
+    DumpSummary             summary;
+    RecordDirectory         directory;
+    StringTable             strings;
+    LoadClassTable          loadClasses;
+    ClassDumpTable          classDumps;
+    InstanceCountTable      classInstanceCount;
+    ObjectDirectory         objects; // instances, arrays and classes
+    GCRootTable             gcRoots;
+    StackFrameTable         stackFrames;
+    StackTraceTable         stackTraces;
+    std::vector<MappedFile> spillFiles; // tables spilled to disk are viewed from these
+};
+
+// bounded-memory parsing: tables that grow with the number of objects are spilled to disk
+// instead of being built in memory
+struct SpillOptions {
+    std::filesystem::path pathPrefix; // of the spill files
+    size_t                memoryBudgetBytes;
+};
+
 DumpSummary summarizeDump(R r, size_t identifierSize);
 
+// heap dump segments are decoded on up to `threads` threads; the record tables are allocated from `tableResource`,
+// so that a caller holding an arena can move them out and release them all at once;
+// with `windows`, r reads the inflated contents of a gzipped dump, which are fetched ahead of every read,
+// and strings are copied into `tableResource`, as windows are released again
+ParsedDump parseDump(R                                  r,
+                     size_t                             identifierSize,
+                     size_t                             threads       = 1,
+                     const std::optional<SpillOptions>& spill         = {},
+                     std::pmr::memory_resource*         tableResource = std::pmr::get_default_resource(),
+                     GzipWindowCache*                   windows       = nullptr);
+
+// reader of the sub-record body of an object, bounded by the end of the dump;
+// with `windows`, bounded by the end of the sub-record, whose windows stay in memory as long as `pin` holds them
+R objectDumpReader(R dump, ObjectLocation location, size_t identifierSize, GzipWindowCache* windows,
+                   GzipWindowCache::Pin& pin);
+
+RecordDirectory buildRecordDirectory(R r, size_t identifierSize);
+
 DumpHeader   parseDumpHeader(R& r);
 RecordHeader parseRecordHeader(R& r);
 
-void parseDumpBody(R r, const std::unordered_map<Tag, TagHandler>& tagHandlers);
+void parseDumpBody(DumpBody body, const std::unordered_map<Tag, TagHandler>& tagHandlers);
 
-std::unordered_map<StringID, StringInUTF8> parseStrings(R r, size_t identifierSize);
+StringInUTF8 parseStringInUTF8(R& r, const RecordHeader& recordHeader, size_t identifierSize);
+LoadClass    parseLoadClass(R& r, size_t identifierSize);
+StackFrame   parseStackFrame(R& r, size_t identifierSize);
+StackTrace   parseStackTrace(R& r, size_t identifierSize, const StackTrace::allocator_type& allocator = {});
 
-std::unordered_map<ClassObjectID, LoadClass> parseLoadClasses(R r, const DumpHeader& dumpHeader);
+StringTable parseStrings(DumpBody body, size_t identifierSize);
 
-void skipClassDump(R& r, size_t identifierSize);
-void skipInstanceDump(R& r, size_t identifierSize);
-void skipObjectArrayDump(R& r, size_t identifierSize);
-void skipPrimitiveArrayDump(R& r, size_t identifierSize);
+LoadClassTable parseLoadClasses(DumpBody body, const DumpHeader& dumpHeader);
+
+// sub-record decoders take the identifier size either as a size_t or as an IdentifierSize<N>
+// specialized at compile time; they are instantiated for size_t, IdentifierSize<4> and IdentifierSize<8>
+
+template <typename IDSize>
+void skipClassDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+void skipInstanceDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+void skipObjectArrayDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+void skipPrimitiveArrayDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+void skipSubRecord(R& r, SubTag subTag, IDSize identifierSize);
 
 void parseHeapDumpSegment(R& r, size_t identifierSize, const std::unordered_map<SubTag, SubTagHandler>& subTagHandlers);
 
 std::function<void(R&, const RecordHeader&)>
 createHeapDumpSegmentHandler(size_t identifierSize, const std::unordered_map<SubTag, SubTagHandler>& subTagHandlers);
 
-std::unordered_map<ClassObjectID, ClassDump> parseClassDumps(R r, size_t identifierSize);
+// runs subTagHandlers over all heap dump segments, skipping segments without handled sub-records if possible
+void parseHeapDump(DumpBody body, size_t identifierSize, const std::unordered_map<SubTag, SubTagHandler>& subTagHandlers);
+
+// the arrays of the class dump are allocated with `allocator`
+template <typename IDSize>
+ClassDump parseClassDump(R& r, IDSize identifierSize, const ClassDump::allocator_type& allocator = {});
+template <typename IDSize>
+InstanceDump parseInstanceDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+ObjectArrayDump parseObjectArrayDump(R& r, IDSize identifierSize);
+template <typename IDSize>
+PrimitiveArrayDump parsePrimitiveArrayDump(R& r, IDSize identifierSize);
+
+RootThread parseRootThread(R& r, size_t identifierSize);
+
+// decodes the body of any ROOT_* sub-record into the table
+template <typename IDSize>
+void parseGCRoot(R& r, SubTag subTag, IDSize identifierSize, GCRootTable::Builder& roots);
 
-std::unordered_map<ClassObjectID, size_t> countInstances(R r, size_t identifierSize);
+ClassDumpTable parseClassDumps(DumpBody body, size_t identifierSize);
 
-InstanceDump parseInstanceDump(R& r, size_t identifierSize);
+InstanceCountTable countInstances(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ObjectID, const std::byte*> parseAllInstanceLocations(R r, size_t identifierSize);
+std::unordered_map<ObjectID, const std::byte*> parseAllInstanceLocations(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ObjectID, InstanceDump> parseClassInstances(R r, size_t identifierSize, ClassObjectID target);
+std::unordered_map<ObjectID, InstanceDump> parseClassInstances(DumpBody body, size_t identifierSize, ClassObjectID target);
 
-std::unordered_map<StackFrameID, StackFrame> parseStackFrames(R r, size_t identifierSize);
+StackFrameTable parseStackFrames(DumpBody body, size_t identifierSize);
 
-std::unordered_map<StackTraceSerialNumber, StackTrace> parseStackTraces(R r, size_t identifierSize);
+StackTraceTable parseStackTraces(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ArrayObjectID, ObjectArrayDump> parseObjectArrayDumps(R r, size_t identifierSize);
+std::unordered_map<ArrayObjectID, ObjectArrayDump> parseObjectArrayDumps(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ArrayObjectID, PrimitiveArrayDump> parsePrimitiveArrayDumps(R r, size_t identifierSize);
+std::unordered_map<ArrayObjectID, PrimitiveArrayDump> parsePrimitiveArrayDumps(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ObjectID, InstanceDump> parseInstanceDumps(R r, size_t identifierSize);
+std::unordered_map<ObjectID, InstanceDump> parseInstanceDumps(DumpBody body, size_t identifierSize);
 
-std::unordered_map<ObjectID, RootThread> parseRootThreads(R r, size_t identifierSize);
+std::unordered_map<ObjectID, RootThread> parseRootThreads(DumpBody body, size_t identifierSize);
@@ -0,0 +1,209 @@
+#pragma once
+
+// Compile-time counterpart of parseDumpBody and parseHeapDumpSegment.
+//
+// A visitor is any object callable as
+//     visitor(TagConstant<tag>{}, R& r, const RecordHeader& recordHeader)
+//     visitor(SubTagConstant<subTag>{}, R& r)
+// for the tags and sub-tags it is interested in; records and sub-records it can't be called
+// with are skipped. Dispatch is a plain switch over the tag, so handlers can be inlined
+// into the parsing loop instead of going through a hash map and a std::function.
+
+#include <data/data.h>
+#include <parse/parse.h>
+#include <utils/reader.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+template <Tag T>
+using TagConstant = std::integral_constant<Tag, T>;
+
+template <SubTag T>
+using SubTagConstant = std::integral_constant<SubTag, T>;
+
+template <typename V, Tag T>
+concept TagVisitor = requires(V& visitor, R& r, const RecordHeader& recordHeader) {
+    visitor(TagConstant<T>{}, r, recordHeader);
+};
+
+template <typename V, SubTag T>
+concept SubTagVisitor = requires(V& visitor, R& r) { visitor(SubTagConstant<T>{}, r); };
+
+inline constexpr std::array ALL_TAGS = {
+    Tag::STRING_IN_UTF8,
+    Tag::LOAD_CLASS,
+    Tag::UNLOAD_CLASS,
+    Tag::STACK_FRAME,
+    Tag::STACK_TRACE,
+    Tag::ALLOC_SITES,
+    Tag::HEAP_SUMMARY,
+    Tag::START_THREAD,
+    Tag::END_THREAD,
+    Tag::HEAP_DUMP,
+    Tag::HEAP_DUMP_SEGMENT,
+    Tag::HEAP_DUMP_END,
+    Tag::CPU_SAMPLES,
+    Tag::CONTROL_SETTINGS,
+};
+
+inline constexpr std::array ALL_SUB_TAGS = {
+    SubTag::ROOT_UNKNOWN,
+    SubTag::ROOT_JNI_GLOBAL,
+    SubTag::ROOT_JNI_LOCAL,
+    SubTag::ROOT_JAVA_FRAME,
+    SubTag::ROOT_NATIVE_STACK,
+    SubTag::ROOT_STICKY_CLASS,
+    SubTag::ROOT_THREAD_BLOCK,
+    SubTag::ROOT_MONITOR_USED,
+    SubTag::ROOT_THREAD_OBJECT,
+    SubTag::CLASS_DUMP,
+    SubTag::INSTANCE_DUMP,
+    SubTag::OBJECT_ARRAY_DUMP,
+    SubTag::PRIMITIVE_ARRAY_DUMP,
+};
+
+template <typename V>
+bool visitsTag(Tag tag) {
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+        return ((tag == ALL_TAGS[I] && TagVisitor<V, ALL_TAGS[I]>) || ...);
+    }(std::make_index_sequence<ALL_TAGS.size()>{});
+}
+
+template <typename V>
+bool visitsSubTag(SubTag subTag) {
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+        return ((subTag == ALL_SUB_TAGS[I] && SubTagVisitor<V, ALL_SUB_TAGS[I]>) || ...);
+    }(std::make_index_sequence<ALL_SUB_TAGS.size()>{});
+}
+
+template <Tag T, typename V>
+void visitRecord(V& visitor, R& r, const RecordHeader& recordHeader) {
+    if constexpr (TagVisitor<V, T>) {
+        visitor(TagConstant<T>{}, r, recordHeader);
+    } else {
+        r.skip(recordHeader.bodyByteSize);
+    }
+}
+
+template <typename V>
+void visitRecord(V& visitor, R& r, const RecordHeader& recordHeader) {
+    switch (recordHeader.tag) {
+        using enum Tag;
+    case STRING_IN_UTF8:    visitRecord<STRING_IN_UTF8>(visitor, r, recordHeader); break;
+    case LOAD_CLASS:        visitRecord<LOAD_CLASS>(visitor, r, recordHeader); break;
+    case UNLOAD_CLASS:      visitRecord<UNLOAD_CLASS>(visitor, r, recordHeader); break;
+    case STACK_FRAME:       visitRecord<STACK_FRAME>(visitor, r, recordHeader); break;
+    case STACK_TRACE:       visitRecord<STACK_TRACE>(visitor, r, recordHeader); break;
+    case ALLOC_SITES:       visitRecord<ALLOC_SITES>(visitor, r, recordHeader); break;
+    case HEAP_SUMMARY:      visitRecord<HEAP_SUMMARY>(visitor, r, recordHeader); break;
+    case START_THREAD:      visitRecord<START_THREAD>(visitor, r, recordHeader); break;
+    case END_THREAD:        visitRecord<END_THREAD>(visitor, r, recordHeader); break;
+    case HEAP_DUMP:         visitRecord<HEAP_DUMP>(visitor, r, recordHeader); break;
+    case HEAP_DUMP_SEGMENT: visitRecord<HEAP_DUMP_SEGMENT>(visitor, r, recordHeader); break;
+    case HEAP_DUMP_END:     visitRecord<HEAP_DUMP_END>(visitor, r, recordHeader); break;
+    case CPU_SAMPLES:       visitRecord<CPU_SAMPLES>(visitor, r, recordHeader); break;
+    case CONTROL_SETTINGS:  visitRecord<CONTROL_SETTINGS>(visitor, r, recordHeader); break;
+    }
+}
+
+template <SubTag T, typename V>
+void visitSubRecord(V& visitor, R& r, size_t identifierSize) {
+    if constexpr (SubTagVisitor<V, T>) {
+        visitor(SubTagConstant<T>{}, r);
+    } else if constexpr (T == SubTag::CLASS_DUMP) {
+        skipClassDump(r, identifierSize);
+    } else if constexpr (T == SubTag::INSTANCE_DUMP) {
+        skipInstanceDump(r, identifierSize);
+    } else if constexpr (T == SubTag::OBJECT_ARRAY_DUMP) {
+        skipObjectArrayDump(r, identifierSize);
+    } else if constexpr (T == SubTag::PRIMITIVE_ARRAY_DUMP) {
+        skipPrimitiveArrayDump(r, identifierSize);
+    } else {
+        r.skip(subTagSize(T, identifierSize));
+    }
+}
+
+template <typename V>
+void visitSubRecord(V& visitor, R& r, SubTag subTag, size_t identifierSize) {
+    switch (subTag) {
+        using enum SubTag;
+    case ROOT_UNKNOWN:         visitSubRecord<ROOT_UNKNOWN>(visitor, r, identifierSize); break;
+    case ROOT_JNI_GLOBAL:      visitSubRecord<ROOT_JNI_GLOBAL>(visitor, r, identifierSize); break;
+    case ROOT_JNI_LOCAL:       visitSubRecord<ROOT_JNI_LOCAL>(visitor, r, identifierSize); break;
+    case ROOT_JAVA_FRAME:      visitSubRecord<ROOT_JAVA_FRAME>(visitor, r, identifierSize); break;
+    case ROOT_NATIVE_STACK:    visitSubRecord<ROOT_NATIVE_STACK>(visitor, r, identifierSize); break;
+    case ROOT_STICKY_CLASS:    visitSubRecord<ROOT_STICKY_CLASS>(visitor, r, identifierSize); break;
+    case ROOT_THREAD_BLOCK:    visitSubRecord<ROOT_THREAD_BLOCK>(visitor, r, identifierSize); break;
+    case ROOT_MONITOR_USED:    visitSubRecord<ROOT_MONITOR_USED>(visitor, r, identifierSize); break;
+    case ROOT_THREAD_OBJECT:   visitSubRecord<ROOT_THREAD_OBJECT>(visitor, r, identifierSize); break;
+    case CLASS_DUMP:           visitSubRecord<CLASS_DUMP>(visitor, r, identifierSize); break;
+    case INSTANCE_DUMP:        visitSubRecord<INSTANCE_DUMP>(visitor, r, identifierSize); break;
+    case OBJECT_ARRAY_DUMP:    visitSubRecord<OBJECT_ARRAY_DUMP>(visitor, r, identifierSize); break;
+    case PRIMITIVE_ARRAY_DUMP: visitSubRecord<PRIMITIVE_ARRAY_DUMP>(visitor, r, identifierSize); break;
+    }
+}
+
+template <typename V>
+void visitDumpBody(DumpBody body, V&& visitor) {
+    if (body.directory != nullptr) {
+        for (const auto& [tag, locations] : body.directory->records) {
+            if (!visitsTag<std::remove_cvref_t<V>>(tag)) {
+                continue;
+            }
+            for (const auto& location : locations) {
+                R br = body.reader.at(location.offset, location.bodyByteSize);
+                visitRecord(visitor, br, RecordHeader{tag, location.micros, location.bodyByteSize});
+            }
+        }
+        return;
+    }
+
+    R r = body.reader;
+    while (!r.eof()) {
+        const auto recordHeader = parseRecordHeader(r);
+        visitRecord(visitor, r, recordHeader);
+    }
+}
+
+template <typename V>
+void visitHeapDumpSegment(R& r, size_t identifierSize, V&& visitor) {
+    while (!r.eof()) {
+        const SubTag subTag = validateSubTag(r.read<uint8_t>());
+        visitSubRecord(visitor, r, subTag, identifierSize);
+    }
+}
+
+// visits sub-records of all heap dump segments, skipping segments without visited sub-records if possible
+template <typename V>
+void visitHeapDump(DumpBody body, size_t identifierSize, V&& visitor) {
+    if (body.directory == nullptr) {
+        visitDumpBody(body,
+                      [&]<Tag T>(TagConstant<T>, R& r, const RecordHeader& recordHeader)
+                          requires(T == Tag::HEAP_DUMP || T == Tag::HEAP_DUMP_SEGMENT)
+                      {
+                          R hdsr(r.it(), recordHeader.bodyByteSize);
+                          visitHeapDumpSegment(hdsr, identifierSize, visitor);
+                          r.skip(recordHeader.bodyByteSize);
+                      });
+        return;
+    }
+
+    for (const auto& segment : body.directory->heapDumpSegments) {
+        uint32_t begin = HeapDumpSegmentLocation::NONE;
+        for (const auto subTag : ALL_SUB_TAGS) {
+            if (visitsSubTag<std::remove_cvref_t<V>>(subTag)) {
+                begin = std::min(begin, segment.firstSubRecordOffsets[subTagIndex(subTag)]);
+            }
+        }
+        if (begin == HeapDumpSegmentLocation::NONE) {
+            continue;
+        }
+        const auto& location = segment.location;
+        R           hdsr     = body.reader.at(location.offset + begin, location.bodyByteSize - begin);
+        visitHeapDumpSegment(hdsr, identifierSize, visitor);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// fixed-size bitmap whose bits can be set concurrently
+class AtomicBitmap {
+
+public:
+    AtomicBitmap() = default;
+
+    explicit AtomicBitmap(size_t size)
+      : words_((size + 63) / 64)
+      , size_(size) {}
+
+public:
+    // true if this call set the bit, false if it was already set
+    bool testAndSet(size_t i) {
+        const uint64_t mask = uint64_t{1} << (i % 64);
+        return (words_[i / 64].fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+    }
+
+    bool test(size_t i) const {
+        return (words_[i / 64].load(std::memory_order_relaxed) >> (i % 64) & 1) != 0;
+    }
+
+    size_t count() const {
+        size_t n = 0;
+        for (const auto& word : words_) {
+            n += std::popcount(word.load(std::memory_order_relaxed));
+        }
+        return n;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> words_;
+    size_t                             size_ = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+// read-only array that either owns its elements or views elements owned elsewhere,
+// e.g. a section of a mapped index file that outlives the column
+template <typename T>
+class Column {
+
+public:
+    Column() = default;
+
+    Column(std::vector<T> elements)
+      : owned_(std::move(elements))
+      , view_(owned_) {}
+
+    static Column view(std::span<const T> elements) {
+        Column column;
+        column.view_ = elements;
+        return column;
+    }
+
+    Column(const Column& other)
+      : owned_(other.owned_)
+      , view_(other.owns_() ? std::span<const T>(owned_) : other.view_) {}
+
+    Column& operator=(const Column& other) {
+        if (this != &other) {
+            owned_ = other.owned_;
+            view_  = other.owns_() ? std::span<const T>(owned_) : other.view_;
+        }
+        return *this;
+    }
+
+    // moving a vector keeps its buffer, so the view stays valid
+    Column(Column&& other) noexcept
+      : owned_(std::move(other.owned_))
+      , view_(std::exchange(other.view_, {})) {}
+
+    Column& operator=(Column&& other) noexcept {
+        if (this != &other) {
+            owned_ = std::move(other.owned_);
+            view_  = std::exchange(other.view_, {});
+        }
+        return *this;
+    }
+
+public:
+    const T& operator[](size_t i) const {
+        return view_[i];
+    }
+
+    size_t size() const {
+        return view_.size();
+    }
+
+    bool empty() const {
+        return view_.empty();
+    }
+
+    const T* data() const {
+        return view_.data();
+    }
+
+    auto begin() const {
+        return view_.begin();
+    }
+
+    auto end() const {
+        return view_.end();
+    }
+
+    std::span<const T> span() const {
+        return view_;
+    }
+
+    operator std::span<const T>() const {
+        return view_;
+    }
+
+    // heap memory owned by the column, viewed elements are not counted
+    size_t memoryBytes() const {
+        return owned_.capacity() * sizeof(T);
+    }
+
+private:
+    bool owns_() const {
+        return view_.data() == owned_.data();
+    }
+
+private:
+    std::vector<T>     owned_;
+    std::span<const T> view_;
+};
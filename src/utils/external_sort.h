@@ -0,0 +1,194 @@
+#pragma once
+
+#include <utils/fs_utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// writes the elements to the end of a binary stream
+template <typename T>
+void appendToFile(std::ofstream& fout, std::span<const T> elements) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    fout.write(reinterpret_cast<const char*>(elements.data()), elements.size_bytes());
+}
+
+// sorts more elements than fit in memory: elements are buffered up to a budget,
+// spilled to disk as sorted runs when it is exceeded and the runs are combined with a k-way merge;
+// the sort is stable, equal elements come out in the order they were added;
+// at most MAX_FAN_IN runs are merged at once, more take several passes through intermediate runs
+template <typename T, typename Less = std::less<T>>
+class ExternalSorter {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    static constexpr size_t MAX_FAN_IN = 64;
+
+    // runs are written to files named pathPrefix.run<N>
+    ExternalSorter(std::filesystem::path pathPrefix, size_t memoryBudgetBytes, Less less = {})
+      : pathPrefix_(std::move(pathPrefix))
+      , capacity_(std::max<size_t>(1, memoryBudgetBytes / sizeof(T)))
+      , less_(std::move(less)) {}
+
+    ~ExternalSorter() {
+        removeRuns_();
+    }
+
+    ExternalSorter(const ExternalSorter&)            = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+public:
+    void add(const T& value) {
+        if (buffer_.size() == capacity_) {
+            spill_();
+        }
+        if (buffer_.size() == buffer_.capacity()) {
+            // grown on demand but never past the budget, so a large budget costs nothing until it is used
+            buffer_.reserve(std::min(capacity_, std::max<size_t>(1024, 2 * buffer_.size())));
+        }
+        buffer_.push_back(value);
+    }
+
+    void add(std::span<const T> values) {
+        for (const auto& value : values) {
+            add(value);
+        }
+    }
+
+    size_t numRuns() const {
+        return runs_.size();
+    }
+
+    // f(const T&) for every element in sorted order; the sorter is empty afterwards
+    template <typename F>
+    void merge(F&& f) {
+        if (runs_.empty()) {
+            std::stable_sort(buffer_.begin(), buffer_.end(), less_);
+            for (const auto& value : buffer_) {
+                f(value);
+            }
+            buffer_.clear();
+            return;
+        }
+        if (!buffer_.empty()) {
+            spill_();
+        }
+        buffer_ = {};
+
+        // consecutive runs are merged, so that earlier elements stay in earlier runs
+        while (runs_.size() > MAX_FAN_IN) {
+            const size_t numRuns = runs_.size();
+            for (size_t begin = 0; begin < numRuns; begin += MAX_FAN_IN) {
+                const size_t end  = std::min(numRuns, begin + MAX_FAN_IN);
+                auto         path = nextRunPath_();
+                {
+                    std::ofstream fout;
+                    fout.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+                    fout.open(path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+
+                    constexpr size_t BLOCK_SIZE = size_t{1} << 16;
+                    std::vector<T>   block;
+                    block.reserve(BLOCK_SIZE);
+                    mergeRuns_(std::span(runs_).subspan(begin, end - begin), [&](const T& value) {
+                        block.push_back(value);
+                        if (block.size() == BLOCK_SIZE) {
+                            appendToFile(fout, std::span<const T>(block));
+                            block.clear();
+                        }
+                    });
+                    appendToFile(fout, std::span<const T>(block));
+                }
+                // kept with the runs until the pass is done, so that they are removed on failure
+                runs_.push_back(std::move(path));
+                for (size_t run = begin; run < end; ++run) {
+                    std::error_code error;
+                    std::filesystem::remove(runs_[run], error);
+                }
+            }
+            runs_.erase(runs_.begin(), runs_.begin() + static_cast<std::ptrdiff_t>(numRuns));
+        }
+
+        mergeRuns_(runs_, f);
+        removeRuns_();
+    }
+
+private:
+    // f(const T&) for every element of the runs in sorted order
+    template <typename F>
+    void mergeRuns_(std::span<const std::filesystem::path> paths, F&& f) {
+        std::vector<MappedFile>         files;
+        std::vector<std::span<const T>> runs;
+        for (const auto& path : paths) {
+            auto& file = files.emplace_back(path);
+            file.advise(MappedFile::Advice::SEQUENTIAL);
+            runs.emplace_back(reinterpret_cast<const T*>(file.data()), file.size() / sizeof(T));
+        }
+
+        // heads of the runs; ties go to the earlier run, which keeps the merge stable
+        using Head           = std::pair<size_t, size_t>; // run, position in it
+        const auto laterHead = [&](const Head& a, const Head& b) {
+            const T& va = runs[a.first][a.second];
+            const T& vb = runs[b.first][b.second];
+            return less_(vb, va) || (!less_(va, vb) && a.first > b.first);
+        };
+        std::priority_queue<Head, std::vector<Head>, decltype(laterHead)> heads(laterHead);
+        for (size_t run = 0; run < runs.size(); ++run) {
+            if (!runs[run].empty()) {
+                heads.emplace(run, 0);
+            }
+        }
+        while (!heads.empty()) {
+            const auto [run, position] = heads.top();
+            heads.pop();
+            f(runs[run][position]);
+            if (position + 1 < runs[run].size()) {
+                heads.emplace(run, position + 1);
+            }
+        }
+    }
+
+    // names stay unique across merge passes, which add runs and drop merged ones
+    std::filesystem::path nextRunPath_() {
+        auto path = pathPrefix_;
+        path += std::format(".run{}", nextRun_++);
+        return path;
+    }
+
+    void spill_() {
+        std::stable_sort(buffer_.begin(), buffer_.end(), less_);
+        auto path = nextRunPath_();
+        {
+            std::ofstream fout;
+            fout.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+            fout.open(path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            appendToFile(fout, std::span<const T>(buffer_));
+        }
+        runs_.push_back(std::move(path));
+        buffer_.clear();
+    }
+
+    void removeRuns_() noexcept {
+        for (const auto& path : runs_) {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+        runs_.clear();
+    }
+
+private:
+    std::filesystem::path              pathPrefix_;
+    size_t                             capacity_;
+    Less                               less_;
+    std::vector<T>                     buffer_;
+    std::vector<std::filesystem::path> runs_;
+    size_t                             nextRun_ = 0;
+};
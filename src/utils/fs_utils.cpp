@@ -1,6 +1,28 @@
 #include <utils/fs_utils.h>
 
+#include <algorithm>
+#include <format>
 #include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 std::vector<std::byte> readWholeFile(const std::filesystem::path& path) {
     std::ifstream fin;
@@ -11,3 +33,269 @@ std::vector<std::byte> readWholeFile(const std::filesystem::path& path) {
     fin.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
     return bytes;
 }
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path, bool temporary) {
+    // an open file can't be deleted, so the system deletes a temporary one when the mapping lets go of it
+    HANDLE file = CreateFileW(path.c_str(),
+                              GENERIC_READ | (temporary ? DELETE : 0),
+                              FILE_SHARE_READ | (temporary ? FILE_SHARE_DELETE : 0),
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN |
+                                  (temporary ? FILE_FLAG_DELETE_ON_CLOSE : 0),
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error(std::format("could not open {} (error {})", path.string(), GetLastError()));
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        const auto error = GetLastError();
+        CloseHandle(file);
+        throw std::runtime_error(std::format("could not get size of {} (error {})", path.string(), error));
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    if (size_ == 0) {
+        CloseHandle(file);
+        return;
+    }
+    mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_ == nullptr) {
+        throw std::runtime_error(std::format("could not map {} (error {})", path.string(), GetLastError()));
+    }
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        const auto error = GetLastError();
+        CloseHandle(mapping_);
+        throw std::runtime_error(std::format("could not map {} (error {})", path.string(), error));
+    }
+}
+
+void MappedFile::advise(Advice advice, size_t offset, size_t length) const {
+    if (data_ == nullptr || offset >= size_ || advice != Advice::WILL_NEED) {
+        return;
+    }
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<std::byte*>(data_ + offset);
+    range.NumberOfBytes  = std::min(length, size_ - offset);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+ReservedMemory::ReservedMemory(size_t size) {
+    if (size == 0) {
+        return;
+    }
+    data_ = static_cast<std::byte*>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+    if (data_ == nullptr) {
+        throw std::runtime_error(std::format("could not reserve {} bytes (error {})", size, GetLastError()));
+    }
+    size_ = size;
+}
+
+size_t ReservedMemory::pageSize() {
+    static const size_t pageSize = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+    }();
+    return pageSize;
+}
+
+void ReservedMemory::commit(size_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (VirtualAlloc(data_ + offset, length, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        throw std::runtime_error(std::format("could not commit {} bytes (error {})", length, GetLastError()));
+    }
+}
+
+void ReservedMemory::decommit(size_t offset, size_t length) noexcept {
+    const size_t begin = (offset + pageSize() - 1) / pageSize() * pageSize();
+    const size_t end   = (offset + length) / pageSize() * pageSize();
+    if (begin < end) {
+        VirtualFree(data_ + begin, end - begin, MEM_DECOMMIT);
+    }
+}
+
+void ReservedMemory::release() noexcept {
+    if (data_ != nullptr) {
+        VirtualFree(data_, 0, MEM_RELEASE);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+    data_    = nullptr;
+    mapping_ = nullptr;
+    size_    = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path, bool temporary) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::format("could not open {}: {}", path.string(), std::strerror(errno)));
+    }
+    if (temporary) {
+        // the open file keeps its data, and so does the mapping once the file is closed
+        ::unlink(path.c_str());
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::format("could not stat {}: {}", path.string(), std::strerror(error)));
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        return;
+    }
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error(std::format("could not map {}: {}", path.string(), std::strerror(errno)));
+    }
+    data_ = static_cast<const std::byte*>(addr);
+}
+
+void MappedFile::advise(Advice advice, size_t offset, size_t length) const {
+    if (data_ == nullptr || offset >= size_) {
+        return;
+    }
+    int posixAdvice = MADV_NORMAL;
+    switch (advice) {
+        using enum Advice;
+    case NORMAL:     posixAdvice = MADV_NORMAL; break;
+    case SEQUENTIAL: posixAdvice = MADV_SEQUENTIAL; break;
+    case RANDOM:     posixAdvice = MADV_RANDOM; break;
+    case WILL_NEED:  posixAdvice = MADV_WILLNEED; break;
+    }
+    // madvise wants a page-aligned start address
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t        begin    = offset / pageSize * pageSize;
+    const size_t        end      = offset + std::min(length, size_ - offset);
+    // advice is only a hint, so failures are deliberately ignored
+    ::madvise(const_cast<std::byte*>(data_ + begin), end - begin, posixAdvice);
+}
+
+ReservedMemory::ReservedMemory(size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // inaccessible pages are not counted against the commit limit, only the committed ones are
+    void* addr = ::mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error(std::format("could not reserve {} bytes: {}", size, std::strerror(errno)));
+    }
+    data_ = static_cast<std::byte*>(addr);
+    size_ = size;
+}
+
+size_t ReservedMemory::pageSize() {
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+void ReservedMemory::commit(size_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    const size_t begin = offset / pageSize() * pageSize();
+    const size_t end   = offset + length;
+    if (::mprotect(data_ + begin, end - begin, PROT_READ | PROT_WRITE) != 0) {
+        throw std::runtime_error(std::format("could not commit {} bytes: {}", length, std::strerror(errno)));
+    }
+}
+
+void ReservedMemory::decommit(size_t offset, size_t length) noexcept {
+    const size_t begin = (offset + pageSize() - 1) / pageSize() * pageSize();
+    const size_t end   = (offset + length) / pageSize() * pageSize();
+    if (begin < end) {
+        ::madvise(data_ + begin, end - begin, MADV_DONTNEED);
+        ::mprotect(data_ + begin, end - begin, PROT_NONE);
+    }
+}
+
+void ReservedMemory::release() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+  : MappedFile(path, false) {}
+
+MappedFile MappedFile::temporary(const std::filesystem::path& path) {
+    try {
+        return MappedFile(path, true);
+    } catch (...) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        throw;
+    }
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr))
+  , size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+  , mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+ReservedMemory::~ReservedMemory() {
+    release();
+}
+
+ReservedMemory::ReservedMemory(ReservedMemory&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr))
+  , size_(std::exchange(other.size_, 0)) {}
+
+ReservedMemory& ReservedMemory::operator=(ReservedMemory&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
@@ -1,7 +1,99 @@
 #pragma once
 
 #include <bit>
+#include <cstddef>
 #include <filesystem>
+#include <limits>
 #include <vector>
 
 std::vector<std::byte> readWholeFile(const std::filesystem::path& path);
+
+// read-only memory mapping of a whole file
+class MappedFile final {
+
+public:
+    enum class Advice {
+        NORMAL,
+        SEQUENTIAL, // linear passes over the whole range
+        RANDOM,     // point lookups, disables read-ahead
+        WILL_NEED,  // start paging in the range
+    };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    // maps a scratch file written by the program and deletes it, its data stays readable as long as it is mapped
+    static MappedFile temporary(const std::filesystem::path& path);
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+public:
+    const std::byte* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // hint to the OS how [offset, offset + length) is going to be accessed
+    void advise(Advice advice, size_t offset = 0, size_t length = std::numeric_limits<size_t>::max()) const;
+
+private:
+    // a temporary file is deleted once it is no longer needed, which on Windows means once it is unmapped
+    MappedFile(const std::filesystem::path& path, bool temporary);
+
+    void unmap() noexcept;
+
+private:
+    const std::byte* data_ = nullptr;
+    size_t           size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+// range of address space whose pages only take up memory while committed;
+// reserving it is cheap, so it can be as large as whatever might be placed in it
+class ReservedMemory final {
+
+public:
+    ReservedMemory() = default;
+    explicit ReservedMemory(size_t size);
+    ~ReservedMemory();
+
+    ReservedMemory(const ReservedMemory&)            = delete;
+    ReservedMemory& operator=(const ReservedMemory&) = delete;
+    ReservedMemory(ReservedMemory&& other) noexcept;
+    ReservedMemory& operator=(ReservedMemory&& other) noexcept;
+
+    static size_t pageSize();
+
+public:
+    std::byte* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // makes every page that [offset, offset + length) touches readable and writable;
+    // new pages are zero-filled, already committed ones keep their contents
+    void commit(size_t offset, size_t length);
+
+    // releases the memory of the pages that lie wholly within [offset, offset + length),
+    // which are inaccessible until committed again
+    void decommit(size_t offset, size_t length) noexcept;
+
+private:
+    void release() noexcept;
+
+private:
+    std::byte* data_ = nullptr;
+    size_t     size_ = 0;
+};
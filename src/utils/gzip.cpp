@@ -0,0 +1,439 @@
+#include <utils/gzip.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#ifdef DUMP_ANALYZER_WITH_ZLIB
+
+#include <zlib.h>
+
+#include <format>
+
+namespace {
+
+// windowBits of inflateInit2 for a gzip stream and for raw deflate data
+constexpr int GZIP_WINDOW_BITS = 15 + 16;
+constexpr int RAW_WINDOW_BITS  = -15;
+
+// avail_in and avail_out are 32-bit
+constexpr size_t MAX_AVAIL = size_t{1} << 30;
+
+// gzip members end with CRC-32 and ISIZE
+constexpr size_t GZIP_TRAILER_SIZE = 8;
+
+// z_stream that is released on scope exit
+class Inflater {
+
+public:
+    explicit Inflater(int windowBits) {
+        if (inflateInit2(&strm, windowBits) != Z_OK) {
+            throw std::runtime_error("could not initialize zlib");
+        }
+    }
+
+    ~Inflater() {
+        inflateEnd(&strm);
+    }
+
+    Inflater(const Inflater&)            = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+public:
+    // feeds the rest of the file in pieces that fit into avail_in
+    void refill(const MappedFile& file) {
+        if (strm.avail_in == 0) {
+            const size_t offset = consumed(file);
+            strm.next_in        = reinterpret_cast<Bytef*>(const_cast<std::byte*>(file.data() + offset));
+            strm.avail_in       = static_cast<uInt>(std::min(file.size() - offset, MAX_AVAIL));
+        }
+    }
+
+    size_t consumed(const MappedFile& file) const {
+        return strm.next_in == nullptr ? 0 : reinterpret_cast<const std::byte*>(strm.next_in) - file.data();
+    }
+
+    // calls inflate, throwing on errors other than running out of input or output space
+    int inflate(int flush) {
+        const int ret = ::inflate(&strm, flush);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            const char* message = strm.msg != nullptr ? strm.msg : "zlib error";
+            throw std::runtime_error(std::format("corrupt gzip data ({})", message));
+        }
+        return ret;
+    }
+
+public:
+    z_stream strm{};
+};
+
+// deflate expands data by at most this factor, which bounds the contents of a file before they are inflated
+constexpr uint64_t MAX_DEFLATE_RATIO = 1032;
+
+// address space reserved for contents of unknown size, whatever the bound says
+constexpr uint64_t MAX_RESERVED_BYTES = uint64_t{1} << 44;
+
+// output the stream commits memory for at a time
+constexpr size_t STREAM_PIECE_BYTES = size_t{1} << 20;
+
+// inflates `output`, which starts at the checkpoint, as in zlib's examples/zran.c
+void inflateFromCheckpoint(const MappedFile& file, const GzipCheckpoint& checkpoint, std::span<std::byte> output) {
+    Inflater inflater(RAW_WINDOW_BITS);
+    auto&    strm = inflater.strm;
+    strm.next_in  = reinterpret_cast<Bytef*>(const_cast<std::byte*>(file.data() + checkpoint.compressedOffset));
+    if (checkpoint.bits != 0) {
+        // the checkpoint is in the middle of the byte before compressedOffset
+        const auto partial = std::to_integer<int>(file.data()[checkpoint.compressedOffset - 1]);
+        inflatePrime(&strm, static_cast<int>(checkpoint.bits), partial >> (8 - checkpoint.bits));
+    }
+    inflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(checkpoint.window.data()), GzipCheckpoint::WINDOW_SIZE);
+
+    bool   raw = true;
+    size_t out = 0;
+    while (out < output.size()) {
+        inflater.refill(file);
+        if (strm.avail_in == 0) {
+            throw std::runtime_error("truncated gzip file");
+        }
+        strm.next_out       = reinterpret_cast<Bytef*>(output.data() + out);
+        strm.avail_out      = static_cast<uInt>(std::min(output.size() - out, MAX_AVAIL));
+        const uInt availOut = strm.avail_out;
+        const int  ret      = inflater.inflate(Z_NO_FLUSH);
+        out += availOut - strm.avail_out;
+        if (ret == Z_STREAM_END && out < output.size()) {
+            // next member; raw inflation does not consume the trailer of the first one
+            if (raw) {
+                const size_t next = std::min(file.size(), inflater.consumed(file) + GZIP_TRAILER_SIZE);
+                strm.next_in      = reinterpret_cast<Bytef*>(const_cast<std::byte*>(file.data() + next));
+                strm.avail_in     = 0;
+                inflateReset2(&strm, GZIP_WINDOW_BITS);
+                raw = false;
+            } else {
+                inflateReset(&strm);
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::vector<std::byte> gunzipPrefix(const MappedFile& file, size_t size) {
+    std::vector<std::byte> prefix(size);
+    Inflater               inflater(GZIP_WINDOW_BITS);
+    inflater.strm.next_out  = reinterpret_cast<Bytef*>(prefix.data());
+    inflater.strm.avail_out = static_cast<uInt>(std::min(size, MAX_AVAIL));
+    while (inflater.strm.avail_out != 0) {
+        inflater.refill(file);
+        if (inflater.strm.avail_in == 0 || inflater.inflate(Z_NO_FLUSH) == Z_STREAM_END) {
+            break;
+        }
+    }
+    prefix.resize(size - inflater.strm.avail_out);
+    return prefix;
+}
+
+struct GzipWindowCache::Stream_ {
+    Inflater inflater{GZIP_WINDOW_BITS};
+    uint64_t total = 0; // output so far
+};
+
+GzipWindowCache::GzipWindowCache(const MappedFile& file, size_t capacityBytes)
+  : file_(file)
+  , capacityBytes_(capacityBytes)
+  , stream_(std::make_unique<Stream_>()) {
+    const uint64_t pageSize = ReservedMemory::pageSize();
+    const uint64_t bound    = std::min(file.size() * MAX_DEFLATE_RATIO + STREAM_PIECE_BYTES, MAX_RESERVED_BYTES);
+    memory_                 = ReservedMemory((bound + pageSize - 1) / pageSize * pageSize);
+    size_                   = memory_.size();
+}
+
+GzipWindowCache::GzipWindowCache(const MappedFile& file, GzipIndex index, size_t capacityBytes)
+  : file_(file)
+  , capacityBytes_(capacityBytes)
+  , size_(index.uncompressedSize)
+  , checkpoints_(std::move(index.checkpoints)) {
+    // the index has no checksum, so the checkpoints are checked before they are inflated from
+    const auto& checkpoints = checkpoints_;
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        const auto& checkpoint = checkpoints[i];
+        const bool  ordered    = i == 0 ? checkpoint.uncompressedOffset == 0
+                                        : checkpoint.uncompressedOffset > checkpoints[i - 1].uncompressedOffset;
+        if (!ordered || checkpoint.uncompressedOffset > size_ || checkpoint.compressedOffset > file.size() ||
+            checkpoint.bits > 7 || (checkpoint.bits != 0 && checkpoint.compressedOffset == 0)) {
+            throw std::runtime_error("gzip checkpoints do not match the file");
+        }
+    }
+    if (checkpoints.empty() && size_ != 0) {
+        throw std::runtime_error("gzip checkpoints do not match the file");
+    }
+    memory_ = ReservedMemory(size_);
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        const uint64_t end = i + 1 < checkpoints.size() ? checkpoints[i + 1].uncompressedOffset : size_;
+        if (checkpoints[i].uncompressedOffset < end) {
+            windows_.emplace_back(checkpoints[i].uncompressedOffset, end, &checkpoints[i]);
+        }
+    }
+}
+
+void GzipWindowCache::load_(size_t window, std::unique_lock<std::mutex>& lock) {
+    auto& w = windows_[window];
+    memory_.commit(w.begin, w.end - w.begin);
+    w.state += LOADING;
+    resident_.push_back(window);
+    residentBytes_ += w.end - w.begin;
+    lock.unlock();
+
+    try {
+        inflateFromCheckpoint(file_, *w.checkpoint, {memory_.data() + w.begin, w.end - w.begin});
+    } catch (...) {
+        lock.lock();
+        w.state -= LOADING;
+        std::erase(resident_, window);
+        residentBytes_ -= w.end - w.begin;
+        decommit_(window);
+        loaded_.notify_all();
+        throw;
+    }
+
+    lock.lock();
+    w.lastUse = ++clock_;
+    w.state += READY - LOADING;
+    loaded_.notify_all();
+}
+
+void GzipWindowCache::advanceStream_(uint64_t end) {
+    auto& strm  = stream_->inflater.strm;
+    auto& total = stream_->total;
+    while (stream_ != nullptr && (windows_.empty() || windows_.back().end < end)) {
+        stream_->inflater.refill(file_);
+        if (strm.avail_in == 0) {
+            throw std::runtime_error("truncated gzip file");
+        }
+        if (strm.avail_out == 0) {
+            const size_t piece = std::min<uint64_t>(STREAM_PIECE_BYTES, memory_.size() - total);
+            if (piece == 0) {
+                throw std::runtime_error("gzip contents are larger than the address space reserved for them");
+            }
+            memory_.commit(total, piece);
+            strm.next_out  = reinterpret_cast<Bytef*>(memory_.data() + total);
+            strm.avail_out = static_cast<uInt>(piece);
+        }
+        const uInt availOut = strm.avail_out;
+        const int  ret      = stream_->inflater.inflate(Z_BLOCK);
+        total += availOut - strm.avail_out;
+
+        const uint64_t windowBegin = streamedCheckpoints_.empty() ? 0 : streamedCheckpoints_.back().uncompressedOffset;
+        if (ret == Z_STREAM_END) {
+            // gzip files may consist of several members
+            const size_t consumed = stream_->inflater.consumed(file_);
+            if (hasGzipMagic({file_.data() + consumed, file_.size() - consumed})) {
+                inflateReset(&strm);
+                continue;
+            }
+            std::lock_guard lock(mutex_);
+            if (windowBegin < total) {
+                auto& w   = windows_.emplace_back(windowBegin, total, &streamedCheckpoints_.back());
+                w.state   = READY;
+                w.lastUse = ++clock_;
+                resident_.push_back(windows_.size() - 1);
+                residentBytes_ += total - windowBegin;
+            }
+            size_ = total;
+            stream_.reset();
+            break;
+        }
+
+        // at the end of a block that is not the last one, or at the start of the deflate data
+        const bool blockBoundary = (strm.data_type & 128) != 0 && (strm.data_type & 64) == 0;
+        if (blockBoundary && (streamedCheckpoints_.empty() || total - windowBegin >= SPAN)) {
+            // the last WINDOW_SIZE bytes of output are in the window still being streamed
+            auto&        checkpoint       = streamedCheckpoints_.emplace_back();
+            const size_t history          = std::min<uint64_t>(total, GzipCheckpoint::WINDOW_SIZE);
+            checkpoint.compressedOffset   = stream_->inflater.consumed(file_);
+            checkpoint.uncompressedOffset = total;
+            checkpoint.bits               = static_cast<uint32_t>(strm.data_type & 7);
+            checkpoint.reserved           = 0;
+            checkpoint.window.fill(std::byte{0});
+            std::copy(memory_.data() + total - history,
+                      memory_.data() + total,
+                      checkpoint.window.end() - static_cast<ptrdiff_t>(history));
+
+            if (streamedCheckpoints_.size() > 1) {
+                std::lock_guard lock(mutex_);
+                const auto& previous = streamedCheckpoints_[streamedCheckpoints_.size() - 2];
+                auto&       w        = windows_.emplace_back(windowBegin, total, &previous);
+                w.state              = READY;
+                w.lastUse            = ++clock_;
+                resident_.push_back(windows_.size() - 1);
+                residentBytes_ += total - windowBegin;
+            }
+        }
+    }
+}
+
+#else
+
+namespace {
+
+[[noreturn]] void throwNoZlib() {
+    throw std::runtime_error("reading gzip-compressed dumps needs a build with zlib, decompress the dump first");
+}
+
+} // namespace
+
+std::vector<std::byte> gunzipPrefix(const MappedFile&, size_t) {
+    throwNoZlib();
+}
+
+struct GzipWindowCache::Stream_ {};
+
+GzipWindowCache::GzipWindowCache(const MappedFile& file, size_t capacityBytes)
+  : file_(file)
+  , capacityBytes_(capacityBytes) {
+    throwNoZlib();
+}
+
+GzipWindowCache::GzipWindowCache(const MappedFile& file, GzipIndex, size_t capacityBytes)
+  : file_(file)
+  , capacityBytes_(capacityBytes) {
+    throwNoZlib();
+}
+
+void GzipWindowCache::load_(size_t, std::unique_lock<std::mutex>&) {
+    throwNoZlib();
+}
+
+void GzipWindowCache::advanceStream_(uint64_t) {
+    throwNoZlib();
+}
+
+#endif
+
+GzipWindowCache::~GzipWindowCache() = default;
+
+GzipWindowCache::Pin GzipWindowCache::fetch(size_t offset, size_t size) {
+    const uint64_t end = offset + std::max<size_t>(size, 1);
+
+    // windows the stream adds are in memory, which may take others out
+    bool loaded = false;
+    if (stream_ != nullptr) {
+        const size_t streamed = windows_.size();
+        advanceStream_(end);
+        loaded = windows_.size() != streamed;
+    }
+
+    Pin pin;
+    pin.end_ = offset;
+    if (windows_.empty() || offset >= windows_.back().end) {
+        return pin;
+    }
+    const auto   byBegin = [](uint64_t o, const Window_& w) { return o < w.begin; };
+    const auto   begin   = windows_.begin();
+    const size_t first   = std::upper_bound(begin, windows_.end(), offset, byBegin) - begin - 1;
+    const size_t last    = std::upper_bound(begin + first, windows_.end(), end - 1, byBegin) - begin;
+
+    // windows are pinned one by one, so a failed load leaves the ones before it to the pin to release
+    pin.cache_ = this;
+    pin.first_ = first;
+    pin.last_  = first;
+    for (size_t window = first; window < last; ++window) {
+        pin_(window, loaded);
+        pin.last_ = window + 1;
+    }
+    pin.end_ = windows_[pin.last_ - 1].end;
+
+    if (loaded) {
+        std::lock_guard lock(mutex_);
+        evict_();
+    }
+    return pin;
+}
+
+void GzipWindowCache::pin_(size_t window, bool& loaded) {
+    auto& w = windows_[window];
+
+    // windows in memory are pinned without taking the lock
+    uint64_t state = w.state.load(std::memory_order_acquire);
+    while ((state & 3) == READY) {
+        if (w.state.compare_exchange_weak(state, state + PINNED, std::memory_order_acquire)) {
+            w.lastUse.store(clock_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    std::unique_lock lock(mutex_);
+    w.state += PINNED;
+    while (true) {
+        const uint64_t status = w.state & 3;
+        if (status == READY) {
+            break;
+        }
+        if (status == LOADING) {
+            loaded_.wait(lock);
+            continue;
+        }
+        try {
+            load_(window, lock);
+        } catch (...) {
+            w.state -= PINNED;
+            throw;
+        }
+        loaded = true;
+    }
+    w.lastUse = clock_.load();
+}
+
+void GzipWindowCache::unpin_(size_t first, size_t last) noexcept {
+    for (size_t window = first; window < last; ++window) {
+        windows_[window].state.fetch_sub(PINNED, std::memory_order_release);
+    }
+}
+
+void GzipWindowCache::evict_() {
+    while (residentBytes_ > capacityBytes_) {
+        // least recently used of the windows in memory that are not pinned
+        size_t victim = resident_.size();
+        for (size_t i = 0; i < resident_.size(); ++i) {
+            const auto& w = windows_[resident_[i]];
+            if (w.state == READY && (victim == resident_.size() || w.lastUse < windows_[resident_[victim]].lastUse)) {
+                victim = i;
+            }
+        }
+        if (victim == resident_.size()) {
+            return;
+        }
+        const size_t window   = resident_[victim];
+        auto&        w        = windows_[window];
+        uint64_t     expected = READY;
+        if (!w.state.compare_exchange_strong(expected, EMPTY)) {
+            continue; // pinned in the meantime
+        }
+        resident_[victim] = resident_.back();
+        resident_.pop_back();
+        residentBytes_ -= w.end - w.begin;
+        decommit_(window);
+    }
+}
+
+void GzipWindowCache::decommit_(size_t window) noexcept {
+    // pages at either end may be shared with a neighbour, they are only released along with the last user
+    const auto& w        = windows_[window];
+    const auto  pageSize = ReservedMemory::pageSize();
+    uint64_t    begin    = w.begin;
+    uint64_t    end      = w.end;
+    if (window == 0 || (windows_[window - 1].state & 3) == EMPTY) {
+        begin = begin / pageSize * pageSize;
+    }
+    const bool streaming = window + 1 == windows_.size() && stream_ != nullptr;
+    if (!streaming && (window + 1 == windows_.size() || (windows_[window + 1].state & 3) == EMPTY)) {
+        end = std::min<uint64_t>((end + pageSize - 1) / pageSize * pageSize, memory_.size());
+    }
+    memory_.decommit(begin, end - begin);
+}
+
+GzipIndex GzipWindowCache::index() const {
+    if (!streamedCheckpoints_.empty()) {
+        return {std::vector<GzipCheckpoint>(streamedCheckpoints_.begin(), streamedCheckpoints_.end()), size_};
+    }
+    return {Column<GzipCheckpoint>::view(checkpoints_), size_};
+}
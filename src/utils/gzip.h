@@ -0,0 +1,189 @@
+#pragma once
+
+#include <utils/column.h>
+#include <utils/fs_utils.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+// whether the data starts like a gzip file
+inline bool hasGzipMagic(std::span<const std::byte> data) {
+    return data.size() >= 2 && data[0] == std::byte{0x1F} && data[1] == std::byte{0x8B};
+}
+
+// enough inflate state to start decompressing a gzip file in the middle, as in zlib's examples/zran.c;
+// checkpoints are taken at deflate block boundaries
+struct GzipCheckpoint {
+    static constexpr size_t WINDOW_SIZE = 32768;
+
+    uint64_t                           compressedOffset;   // of the first byte not fully consumed
+    uint64_t                           uncompressedOffset; // of the output produced from there
+    uint32_t                           bits;               // unconsumed bits of the byte before compressedOffset
+    uint32_t                           reserved;
+    std::array<std::byte, WINDOW_SIZE> window; // last WINDOW_SIZE bytes of output, as a dictionary
+};
+
+// checkpoints of a gzip file, found while inflating it once
+struct GzipIndex {
+    Column<GzipCheckpoint> checkpoints; // the first one is at the start of the compressed data
+    uint64_t               uncompressedSize = 0;
+};
+
+// first `size` bytes of the decompressed contents, or all of them if there are fewer
+std::vector<std::byte> gunzipPrefix(const MappedFile& file, size_t size);
+
+// random access to the decompressed contents of a gzip file through a bounded cache of windows:
+// a window is the output between two consecutive checkpoints, and it is inflated from the first of them
+// whenever it is fetched while not in memory;
+// windows sit at their offset in one reserved range of address space, so a fetched range is contiguous
+// even if it spans several windows
+class GzipWindowCache {
+
+public:
+    // output between two checkpoints taken while streaming, at least
+    static constexpr size_t SPAN = size_t{8} << 20;
+
+    class Pin;
+
+    // the file is inflated as a stream as far as it is fetched, taking checkpoints on the way;
+    // until the stream reaches the end, fetches must come from one thread at a time
+    GzipWindowCache(const MappedFile& file, size_t capacityBytes);
+
+    // the checkpoints are those of an earlier pass, viewed in place
+    GzipWindowCache(const MappedFile& file, GzipIndex index, size_t capacityBytes);
+
+    ~GzipWindowCache();
+
+    GzipWindowCache(const GzipWindowCache&)            = delete;
+    GzipWindowCache& operator=(const GzipWindowCache&) = delete;
+
+public:
+    // start of the contents, of which only fetched ranges are readable
+    const std::byte* data() const {
+        return memory_.data();
+    }
+
+    // of the contents, or of the reserved address space while the stream has not reached the end
+    size_t size() const {
+        return size_;
+    }
+
+    size_t capacityBytes() const {
+        return capacityBytes_;
+    }
+
+    // makes [offset, offset + size) readable for as long as the pin is held, or the part of it the contents have;
+    // windows that are not pinned are evicted, least recently used first, while more than capacityBytes
+    // are in memory
+    Pin fetch(size_t offset, size_t size);
+
+    // checkpoints to save for later runs, complete once the stream has reached the end
+    GzipIndex index() const;
+
+private:
+    static constexpr uint64_t EMPTY   = 0;
+    static constexpr uint64_t LOADING = 1;
+    static constexpr uint64_t READY   = 2;
+    static constexpr uint64_t PINNED  = 4; // one pin, added to the state
+
+    struct Window_ {
+        Window_(uint64_t begin_, uint64_t end_, const GzipCheckpoint* checkpoint_)
+          : begin(begin_)
+          , end(end_)
+          , checkpoint(checkpoint_) {}
+
+        uint64_t              begin;
+        uint64_t              end;
+        const GzipCheckpoint* checkpoint;
+        std::atomic<uint64_t> state = EMPTY; // number of pins * PINNED | EMPTY, LOADING or READY
+        std::atomic<uint64_t> lastUse = 0;
+    };
+
+    struct Stream_;
+
+    void pin_(size_t window, bool& loaded);
+    void unpin_(size_t first, size_t last) noexcept;
+    void load_(size_t window, std::unique_lock<std::mutex>& lock);
+    void evict_();
+    void decommit_(size_t window) noexcept;
+    void advanceStream_(uint64_t end);
+
+private:
+    const MappedFile&          file_;
+    size_t                     capacityBytes_;
+    ReservedMemory             memory_;
+    size_t                     size_ = 0;
+    Column<GzipCheckpoint>     checkpoints_;         // of an index
+    std::deque<GzipCheckpoint> streamedCheckpoints_; // taken by the stream
+    std::deque<Window_>        windows_;
+    std::unique_ptr<Stream_>   stream_; // until it reaches the end
+
+    std::mutex              mutex_; // guards loading and evicting
+    std::condition_variable loaded_;
+    std::vector<size_t>     resident_; // windows that are loading or in memory
+    size_t                  residentBytes_ = 0;
+    std::atomic<uint64_t>   clock_         = 0; // ticks once per window brought in
+};
+
+// windows in use by a fetch, which are not evicted while it is held
+class GzipWindowCache::Pin {
+
+public:
+    Pin() = default;
+
+    ~Pin() {
+        release();
+    }
+
+    Pin(const Pin&)            = delete;
+    Pin& operator=(const Pin&) = delete;
+
+    Pin(Pin&& other) noexcept
+      : cache_(std::exchange(other.cache_, nullptr))
+      , first_(other.first_)
+      , last_(other.last_)
+      , end_(other.end_) {}
+
+    Pin& operator=(Pin&& other) noexcept {
+        if (this != &other) {
+            release();
+            cache_ = std::exchange(other.cache_, nullptr);
+            first_ = other.first_;
+            last_  = other.last_;
+            end_   = other.end_;
+        }
+        return *this;
+    }
+
+public:
+    // end of what is readable from the fetched offset on: the end of the last pinned window,
+    // which is before the end of the fetched range only where the contents end
+    size_t end() const {
+        return end_;
+    }
+
+    void release() noexcept {
+        if (cache_ != nullptr) {
+            std::exchange(cache_, nullptr)->unpin_(first_, last_);
+        }
+    }
+
+private:
+    friend class GzipWindowCache;
+
+    GzipWindowCache* cache_ = nullptr;
+    size_t           first_ = 0; // pinned windows [first_, last_)
+    size_t           last_  = 0;
+    size_t           end_   = 0;
+};
+
+// all of the above throw if the program was built without zlib
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// calls f(i, thread) for every i in [0, n) on up to `threads` threads, thread is in [0, threads);
+// indices are handed out one by one, so uneven work items balance out;
+// the first exception thrown by f stops the remaining work and is rethrown
+template <typename F>
+void parallelFor(size_t n, size_t threads, F&& f) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    if (threads == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            f(i, size_t{0});
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool>   failed{false};
+    std::exception_ptr  error;
+    std::mutex          errorMutex;
+
+    const auto worker = [&](size_t thread) {
+        try {
+            for (size_t i = next.fetch_add(1); i < n && !failed; i = next.fetch_add(1)) {
+                f(i, thread);
+            }
+        } catch (...) {
+            std::lock_guard lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(worker, thread);
+    }
+    worker(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
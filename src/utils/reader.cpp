@@ -0,0 +1,99 @@
+#include <utils/reader.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define READER_X86_KERNELS
+#define TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void loadScalar(const std::byte* p, size_t n, std::span<uint64_t> ids) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = loadBigEndian(p + i * n, n);
+    }
+}
+
+#ifdef READER_X86_KERNELS
+
+// kernels decode whole vectors and leave the remaining identifiers to loadScalar
+
+TARGET("ssse3") size_t load4Ssse3(const std::byte* p, std::span<uint64_t> ids) {
+    // four identifiers per load, byte-swapped and zero-extended two at a time
+    const __m128i low  = _mm_setr_epi8(3, 2, 1, 0, -1, -1, -1, -1, 7, 6, 5, 4, -1, -1, -1, -1);
+    const __m128i high = _mm_setr_epi8(11, 10, 9, 8, -1, -1, -1, -1, 15, 14, 13, 12, -1, -1, -1, -1);
+    size_t        i    = 0;
+    for (; i + 4 <= ids.size(); i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ids.data() + i), _mm_shuffle_epi8(v, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ids.data() + i + 2), _mm_shuffle_epi8(v, high));
+    }
+    return i;
+}
+
+TARGET("ssse3") size_t load8Ssse3(const std::byte* p, std::span<uint64_t> ids) {
+    const __m128i swap = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    size_t        i    = 0;
+    for (; i + 2 <= ids.size(); i += 2) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ids.data() + i), _mm_shuffle_epi8(v, swap));
+    }
+    return i;
+}
+
+TARGET("avx2") size_t load4Avx2(const std::byte* p, std::span<uint64_t> ids) {
+    const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t        i    = 0;
+    for (; i + 4 <= ids.size(); i += 4) {
+        const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4)), swap);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ids.data() + i), _mm256_cvtepu32_epi64(v));
+    }
+    return i;
+}
+
+TARGET("avx2") size_t load8Avx2(const std::byte* p, std::span<uint64_t> ids) {
+    // the shuffle works within 128-bit lanes, so both lanes use the same pattern
+    const __m256i swap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    size_t        i    = 0;
+    for (; i + 4 <= ids.size(); i += 4) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ids.data() + i), _mm256_shuffle_epi8(v, swap));
+    }
+    return i;
+}
+
+using Kernel = size_t (*)(const std::byte*, std::span<uint64_t>);
+
+struct Kernels {
+    Kernel load4 = nullptr;
+    Kernel load8 = nullptr;
+};
+
+Kernels selectKernels() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {load4Avx2, load8Avx2};
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return {load4Ssse3, load8Ssse3};
+    }
+    return {};
+}
+
+#endif
+
+} // namespace
+
+void loadBigEndianIDs(const std::byte* p, size_t n, std::span<uint64_t> ids) {
+    size_t done = 0;
+#ifdef READER_X86_KERNELS
+    static const Kernels kernels = selectKernels();
+    if (n == 4 && kernels.load4 != nullptr) {
+        done = kernels.load4(p, ids);
+    } else if (n == 8 && kernels.load8 != nullptr) {
+        done = kernels.load8(p, ids);
+    }
+#endif
+    loadScalar(p + done * n, n, ids.subspan(done));
+}
@@ -1,30 +1,115 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <span>
 #include <stdexcept>
+#include <type_traits>
 
-class R final {
+template <std::unsigned_integral T>
+constexpr T byteswap(T v) {
+    T swapped = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        swapped = static_cast<T>(swapped << 8) | static_cast<T>(v & 0xFF);
+        v >>= 8;
+    }
+    return swapped;
+}
+
+// n-byte (1 <= n <= 8) big-endian unsigned value at p, without bounds checks
+inline uint64_t loadBigEndian(const std::byte* p, size_t n) {
+    uint64_t v = 0;
+    if constexpr (std::endian::native == std::endian::big) {
+        std::memcpy(reinterpret_cast<std::byte*>(&v) + sizeof(v) - n, p, n);
+        return v;
+    } else {
+        std::memcpy(&v, p, n);
+        return byteswap(v) >> (8 * (sizeof(v) - n));
+    }
+}
+
+// N-byte (4 or 8) big-endian unsigned value at p, as a single load and byte swap
+template <size_t N>
+uint64_t loadBigEndian(const std::byte* p) {
+    static_assert(N == 4 || N == 8);
+    using U = std::conditional_t<N == 4, uint32_t, uint64_t>;
+    U v;
+    std::memcpy(&v, p, N);
+    if constexpr (std::endian::native == std::endian::little) {
+        v = byteswap(v);
+    }
+    return v;
+}
+
+// identifier size fixed at compile time; it converts to size_t, so that decoders can be written once
+// for either this or a plain size_t and get constant-size reads for the common sizes
+template <size_t N>
+struct IdentifierSize {
+    static_assert(N == 4 || N == 8);
+
+    constexpr operator size_t() const {
+        return N;
+    }
+};
+
+// f(IdentifierSize<4>{}) or f(IdentifierSize<8>{}) for the common sizes, f(identifierSize) otherwise
+template <typename F>
+decltype(auto) withIdentifierSize(size_t identifierSize, F&& f) {
+    switch (identifierSize) {
+    case 4:  return f(IdentifierSize<4>{});
+    case 8:  return f(IdentifierSize<8>{});
+    default: return f(identifierSize);
+    }
+}
+
+// decodes ids.size() consecutive big-endian identifiers of n bytes each at p, without bounds checks;
+// 4- and 8-byte identifiers are byte-swapped with SIMD shuffles where the CPU supports them
+void loadBigEndianIDs(const std::byte* p, size_t n, std::span<uint64_t> ids);
+
+// how a reader treats its bounds: checked readers verify every read and throw on overrun,
+// unchecked ones trust that the range they read was validated as a whole beforehand
+enum class Bounds {
+    CHECKED,
+    UNCHECKED,
+};
+
+// builds with DUMP_ANALYZER_STRICT_READS (for fuzzing and corrupt dumps) check unchecked readers too
+#ifdef DUMP_ANALYZER_STRICT_READS
+inline constexpr bool STRICT_READS = true;
+#else
+inline constexpr bool STRICT_READS = false;
+#endif
+
+template <Bounds B>
+class Reader final {
+
+    static constexpr bool CHECKS = B == Bounds::CHECKED || STRICT_READS;
 
 public:
-    R(const std::byte* begin, size_t size = std::numeric_limits<size_t>::max())
+    Reader(const std::byte* begin, size_t size = std::numeric_limits<size_t>::max())
       : begin_(begin)
       , size_(size)
       , read_(0) {}
 
 public:
-    R(const R&)            = default;
-    R& operator=(const R&) = default;
-    R(R&&)                 = default;
-    R& operator=(R&&)      = default;
+    Reader(const Reader&)            = default;
+    Reader& operator=(const Reader&) = default;
+    Reader(Reader&&)                 = default;
+    Reader& operator=(Reader&&)      = default;
 
 public:
     template <typename T, std::endian E = std::endian::big>
     void read(T& v, size_t n) {
-        if (n > sizeof(T)) {
-            throw std::runtime_error("n must be <= sizeof(v)");
+        if constexpr (CHECKS) {
+            if (n > sizeof(T)) {
+                throw std::runtime_error("n must be <= sizeof(v)");
+            }
         }
         ensure(n);
         std::byte* dst = reinterpret_cast<std::byte*>(&v);
@@ -42,6 +127,15 @@ public:
         read_ += n;
     }
 
+    // n known at compile time, a single load and byte swap
+    template <typename T, size_t N>
+    void read(T& v, IdentifierSize<N>) {
+        static_assert(N <= sizeof(T));
+        ensure(N);
+        v = static_cast<T>(loadBigEndian<N>(it()));
+        read_ += N;
+    }
+
     template <std::endian E = std::endian::big>
     void read(auto& v) {
         const size_t n = sizeof(v);
@@ -69,6 +163,13 @@ public:
         return v;
     }
 
+    template <typename T, size_t N>
+    T read(IdentifierSize<N> n) {
+        T v{0};
+        read(v, n);
+        return v;
+    }
+
     std::span<const std::byte> skip(size_t nbytes) {
         ensure(nbytes);
         std::span<const std::byte> skippedBytes(it(), nbytes);
@@ -76,10 +177,47 @@ public:
         return skippedBytes;
     }
 
+    // reads ids.size() identifiers of n bytes each with a single bounds check
+    void readIDs(std::span<uint64_t> ids, size_t n) {
+        if constexpr (CHECKS) {
+            if (n != 0 && ids.size() > std::numeric_limits<size_t>::max() / n) {
+                throw std::runtime_error("out of bounds read");
+            }
+        }
+        ensure(ids.size() * n);
+        loadBigEndianIDs(it(), n, ids);
+        read_ += ids.size() * n;
+    }
+
     void reset() {
         read_ = 0;
     }
 
+    // reader over [offset, offset + nbytes) of the whole underlying range
+    Reader at(size_t offset, size_t nbytes) const {
+        if (offset > size_ || size_ - offset < nbytes) {
+            throw std::runtime_error("out of bounds read");
+        }
+        return Reader(begin_ + offset, nbytes);
+    }
+
+    // unchecked reader over the next nbytes, which are checked once here and skipped;
+    // meant for the fixed-size part of a record that is then decoded field by field
+    Reader<Bounds::UNCHECKED> validated(size_t nbytes) {
+        ensure(nbytes);
+        Reader<Bounds::UNCHECKED> window(it(), nbytes);
+        read_ += nbytes;
+        return window;
+    }
+
+    size_t offset() const {
+        return read_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
     bool eof() const {
         return read_ == size_;
     }
@@ -89,9 +227,11 @@ public:
     }
 
 private:
-    void ensure(size_t nbytes) {
-        if (read_ > size_ || size_ - read_ < nbytes) {
-            throw std::runtime_error("out of bounds read");
+    void ensure(size_t nbytes) const {
+        if constexpr (CHECKS) {
+            if (read_ > size_ || size_ - read_ < nbytes) {
+                throw std::runtime_error("out of bounds read");
+            }
         }
     }
 
@@ -100,3 +240,22 @@ private:
     const size_t     size_;
     size_t           read_;
 };
+
+using R          = Reader<Bounds::CHECKED>;
+using UncheckedR = Reader<Bounds::UNCHECKED>;
+
+// f(uint64_t) for every identifier of n bytes in bytes, decoded in batches
+template <typename F>
+void forEachBigEndianID(std::span<const std::byte> bytes, size_t n, F&& f) {
+    constexpr size_t                 BATCH_SIZE = 256;
+    std::array<uint64_t, BATCH_SIZE> ids;
+    UncheckedR                       r(bytes.data(), bytes.size());
+    for (size_t left = n == 0 ? 0 : bytes.size() / n; left > 0;) {
+        const auto batch = std::span(ids).first(std::min(left, BATCH_SIZE));
+        r.readIDs(batch, n);
+        for (const auto id : batch) {
+            f(id);
+        }
+        left -= batch.size();
+    }
+}
@@ -0,0 +1,223 @@
+#include <utils/stats.h>
+
+#include <algorithm>
+#include <format>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef _WIN32
+
+ResourceUsage resourceUsage() {
+    ResourceUsage usage;
+    FILETIME      creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        // in units of 100 ns
+        const auto seconds = [](const FILETIME& t) {
+            return static_cast<double>(static_cast<uint64_t>(t.dwHighDateTime) << 32 | t.dwLowDateTime) * 1e-7;
+        };
+        usage.cpuSeconds = seconds(kernel) + seconds(user);
+    }
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.peakRSSBytes = counters.PeakWorkingSetSize;
+    }
+    return usage;
+}
+
+#else
+
+ResourceUsage resourceUsage() {
+    ResourceUsage usage;
+    rusage        self;
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        const auto seconds = [](const timeval& t) {
+            return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec) * 1e-6;
+        };
+        usage.cpuSeconds = seconds(self.ru_utime) + seconds(self.ru_stime);
+#ifdef __APPLE__
+        usage.peakRSSBytes = static_cast<size_t>(self.ru_maxrss); // in bytes
+#else
+        usage.peakRSSBytes = static_cast<size_t>(self.ru_maxrss) * 1024; // in KiB
+#endif
+    }
+    return usage;
+}
+
+#endif
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double mebibytes(size_t bytes) {
+    return static_cast<double>(bytes) / (1 << 20);
+}
+
+// throughput column, empty if the phase did not process any bytes or records
+std::string formatRate(uint64_t amount, double seconds, double unit, int precision) {
+    if (amount == 0 || seconds <= 0) {
+        return "";
+    }
+    return std::format("{:.{}f}", static_cast<double>(amount) / seconds / unit, precision);
+}
+
+std::string formatCount(uint64_t count) {
+    return count == 0 ? "" : std::format("{}", count);
+}
+
+// names are fixed strings of the program, only quotes and backslashes need escaping
+std::string quoteJSON(std::string_view text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+} // namespace
+
+RunStats::PhaseScope::PhaseScope(RunStats& stats, std::string name)
+  : stats_(stats)
+  , phase_(stats.phases_.size())
+  , start_(std::chrono::steady_clock::now())
+  , startCPUSeconds_(resourceUsage().cpuSeconds) {
+    stats_.phases_.push_back({.name = std::move(name), .depth = stats_.depth_});
+    ++stats_.depth_;
+}
+
+RunStats::PhaseScope::~PhaseScope() {
+    finish();
+}
+
+void RunStats::PhaseScope::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    const auto usage   = resourceUsage();
+    auto&      phase   = stats_.phases_[phase_];
+    phase.wallSeconds  = secondsSince(start_);
+    phase.cpuSeconds   = usage.cpuSeconds - startCPUSeconds_;
+    phase.peakRSSBytes = usage.peakRSSBytes;
+    phase.bytes        = bytes_;
+    phase.records      = records_;
+    --stats_.depth_;
+}
+
+RunStats::RunStats()
+  : start_(std::chrono::steady_clock::now())
+  , startCPUSeconds_(resourceUsage().cpuSeconds) {}
+
+RunStats::Phase RunStats::total_() const {
+    const auto usage = resourceUsage();
+    return {.name         = "total",
+            .wallSeconds  = secondsSince(start_),
+            .cpuSeconds   = usage.cpuSeconds - startCPUSeconds_,
+            .peakRSSBytes = usage.peakRSSBytes};
+}
+
+void RunStats::print(std::ostream& out) const {
+    constexpr size_t INDENT_STEP = 2;
+
+    auto phases = phases_;
+    phases.push_back(total_());
+    size_t nameWidth = 5;
+    for (const auto& phase : phases) {
+        nameWidth = std::max(nameWidth, phase.depth * INDENT_STEP + phase.name.size());
+    }
+
+    out << "\nPhases:\n\n";
+    out << std::format("{:{}} | {:>10} | {:>10} | {:>12} | {:>12} | {:>10} | {:>14} | {:>12}\n",
+                       "phase",
+                       nameWidth,
+                       "wall s",
+                       "CPU s",
+                       "bytes",
+                       "records",
+                       "MiB/s",
+                       "records/s",
+                       "peak RSS MiB");
+    out << std::format("{:-<{}}-+-{:-<10}-+-{:-<10}-+-{:-<12}-+-{:-<12}-+-{:-<10}-+-{:-<14}-+-{:-<12}\n",
+                       "",
+                       nameWidth,
+                       "",
+                       "",
+                       "",
+                       "",
+                       "",
+                       "",
+                       "");
+    for (const auto& phase : phases) {
+        out << std::format("{:{}} | {:>10.3f} | {:>10.3f} | {:>12} | {:>12} | {:>10} | {:>14} | {:>12.1f}\n",
+                           std::string(phase.depth * INDENT_STEP, ' ') + phase.name,
+                           nameWidth,
+                           phase.wallSeconds,
+                           phase.cpuSeconds,
+                           formatCount(phase.bytes),
+                           formatCount(phase.records),
+                           formatRate(phase.bytes, phase.wallSeconds, 1 << 20, 1),
+                           formatRate(phase.records, phase.wallSeconds, 1, 0),
+                           mebibytes(phase.peakRSSBytes));
+    }
+
+    size_t tableNameWidth = 5;
+    size_t totalBytes     = 0;
+    for (const auto& table : tables_) {
+        tableNameWidth = std::max(tableNameWidth, table.name.size());
+        totalBytes += table.memoryBytes;
+    }
+    out << "\nTables (estimated heap memory, data used in place from mappings is not counted):\n\n";
+    out << std::format("{:{}} | {:>12} | {:>10}\n", "table", tableNameWidth, "entries", "MiB");
+    out << std::format("{:-<{}}-+-{:-<12}-+-{:-<10}\n", "", tableNameWidth, "", "");
+    for (const auto& table : tables_) {
+        out << std::format(
+            "{:{}} | {:>12} | {:>10.1f}\n", table.name, tableNameWidth, table.entries, mebibytes(table.memoryBytes));
+    }
+    out << std::format("{:{}} | {:>12} | {:>10.1f}\n", "total", tableNameWidth, "", mebibytes(totalBytes));
+}
+
+void RunStats::printJSON(std::ostream& out) const {
+    const auto phaseJSON = [](const Phase& phase) {
+        return std::format("{{\"name\": {}, \"depth\": {}, \"wallSeconds\": {}, \"cpuSeconds\": {}, "
+                           "\"bytes\": {}, \"records\": {}, \"peakRSSBytes\": {}}}",
+                           quoteJSON(phase.name),
+                           phase.depth,
+                           phase.wallSeconds,
+                           phase.cpuSeconds,
+                           phase.bytes,
+                           phase.records,
+                           phase.peakRSSBytes);
+    };
+
+    out << "{\n  \"phases\": [";
+    for (size_t i = 0; i < phases_.size(); ++i) {
+        out << (i == 0 ? "\n    " : ",\n    ") << phaseJSON(phases_[i]);
+    }
+    out << "\n  ],\n  \"total\": " << phaseJSON(total_()) << ",\n  \"tables\": [";
+    for (size_t i = 0; i < tables_.size(); ++i) {
+        out << (i == 0 ? "\n    " : ",\n    ")
+            << std::format("{{\"name\": {}, \"entries\": {}, \"memoryBytes\": {}}}",
+                           quoteJSON(tables_[i].name),
+                           tables_[i].entries,
+                           tables_[i].memoryBytes);
+    }
+    out << "\n  ]\n}\n";
+}
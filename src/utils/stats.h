@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// of the whole process, all threads included
+struct ResourceUsage {
+    double cpuSeconds   = 0; // user and system
+    size_t peakRSSBytes = 0;
+};
+
+ResourceUsage resourceUsage();
+
+// node-based maps take a node per entry, with the value and a link to the next node, and a pointer per bucket;
+// heap memory owned by the values themselves is not counted
+template <typename K, typename V, typename... Rest>
+size_t estimateMemoryBytes(const std::unordered_map<K, V, Rest...>& map) {
+    struct Node {
+        void*                                                  next;
+        typename std::unordered_map<K, V, Rest...>::value_type value;
+    };
+    return map.bucket_count() * sizeof(void*) + map.size() * sizeof(Node);
+}
+
+// wall and CPU time, peak RSS and amount of work of the phases of a run, and sizes of the tables it built
+class RunStats {
+
+public:
+    struct Phase {
+        std::string name;
+        size_t      depth        = 0; // phases started while others are running are nested in them
+        double      wallSeconds  = 0;
+        double      cpuSeconds   = 0;
+        size_t      peakRSSBytes = 0; // at the end of the phase
+        uint64_t    bytes        = 0; // processed, 0 if not applicable
+        uint64_t    records      = 0; // records, objects or entries processed, 0 if not applicable
+    };
+
+    struct Table {
+        std::string name;
+        size_t      entries     = 0;
+        size_t      memoryBytes = 0; // estimated heap memory, mapped memory is not counted
+    };
+
+    // measures a phase from construction to destruction
+    class PhaseScope {
+
+    public:
+        PhaseScope(RunStats& stats, std::string name);
+        ~PhaseScope();
+
+        PhaseScope(const PhaseScope&)            = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+    public:
+        void processed(uint64_t bytes, uint64_t records) {
+            bytes_   = bytes;
+            records_ = records;
+        }
+
+        // ends the phase before the scope does
+        void finish();
+
+    private:
+        RunStats&                             stats_;
+        size_t                                phase_;
+        std::chrono::steady_clock::time_point start_;
+        double                                startCPUSeconds_;
+        uint64_t                              bytes_    = 0;
+        uint64_t                              records_  = 0;
+        bool                                  finished_ = false;
+    };
+
+public:
+    RunStats();
+
+public:
+    [[nodiscard]] PhaseScope phase(std::string name) {
+        return PhaseScope(*this, std::move(name));
+    }
+
+    void addTable(std::string name, size_t entries, size_t memoryBytes) {
+        tables_.push_back({std::move(name), entries, memoryBytes});
+    }
+
+    void clearTables() {
+        tables_.clear();
+    }
+
+    void print(std::ostream& out) const;
+    void printJSON(std::ostream& out) const;
+
+private:
+    // totals since construction
+    Phase total_() const;
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    double                                startCPUSeconds_;
+    std::vector<Phase>                    phases_; // in the order they were started
+    std::vector<Table>                    tables_;
+    size_t                                depth_ = 0;
+};